@@ -51,8 +51,8 @@ int directed_graph::remove_edge(edge_descriptor e)
 	if(se.find(e) == se.end()) return -1;
 	vv[e->source()]->remove_out_edge(e);
 	vv[e->target()]->remove_in_edge(e);
-	delete e;
 	se.erase(e);
+	retired.push_back(e);
 	return 0;
 }
 
@@ -62,7 +62,7 @@ int directed_graph::remove_edge(edge_descriptor e)
 // 	assert(y >= 0 && y < num_vertices());
 // 	assert(z >= 0 && z < num_vertices());
 
-// 	set<edge_descriptor> m;
+// 	SE m;
 // 	PEEI pei;
 // 	edge_iterator it1, it2;
 // 	for(pei = out_edges(x), it1 = pei.first, it2 = pei.second; it1 != it2; it1++)
@@ -86,7 +86,7 @@ int directed_graph::remove_edge(edge_descriptor e)
 // 		m.insert(*it1);
 // 	}
 
-// 	for(set<edge_descriptor>::iterator it = m.begin(); it != m.end(); it++)
+// 	for(SE::iterator it = m.begin(); it != m.end(); it++)
 // 	{
 // 		int s = (*it)->source();
 // 		int t = (*it)->target();
@@ -105,11 +105,11 @@ int directed_graph::rotate(int x, int y)
 {
 	if(check_path(y, x) == true) return rotate(y, x);
 
-	set<edge_descriptor> se;
+	SE se;
 	int f = check_nest(x, y, se);
 	assert(f >= 0);
 
-	for(set<edge_descriptor>::iterator it = se.begin(); it != se.end(); it++)
+	for(SE::iterator it = se.begin(); it != se.end(); it++)
 	{
 		int s = (*it)->source();
 		int t = (*it)->target();
@@ -179,7 +179,7 @@ int directed_graph::move_edge(edge_base *e, int x, int y)
 	return 0;
 }
 
-bool directed_graph::bfs_reverse(const vector<int> &t, int s, const set<edge_descriptor> &fb)
+bool directed_graph::bfs_reverse(const vector<int> &t, int s, const SE &fb)
 {
 	vector<int> open = t;
 	set<int> closed(t.begin(), t.end());
@@ -237,7 +237,7 @@ int directed_graph::bfs_reverse(int t, vector<int> &v, vector<int> &b)
 	return 0;
 }
 
-int directed_graph::bfs_reverse(int t, set<edge_descriptor> &ss)
+int directed_graph::bfs_reverse(int t, SE &ss)
 {
 	ss.clear();
 	set<int> closed;
@@ -433,7 +433,7 @@ vector<int> directed_graph::topological_sort()
 // 		order[v[i]] = i;
 // 	}
 
-// 	set<edge_descriptor> se;
+// 	SE se;
 // 	set<int> sv;
 // 	edge_iterator it1, it2;
 // 	PEEI pei;
@@ -485,7 +485,7 @@ vector<int> directed_graph::topological_sort()
 // 		order[v[i]] = i;
 // 	}
 
-// 	set<edge_descriptor> se;
+// 	SE se;
 // 	set<int> sv;
 // 	edge_iterator it1, it2;
 // 	PEEI pei;
@@ -630,11 +630,11 @@ int directed_graph::compute_in_equivalent_vertex(int x)
 
 int directed_graph::check_nest(int x, int y, const vector<int> &tpo)
 {
-	set<edge_descriptor> se;
+	SE se;
 	return check_nest(x, y, se, tpo);
 }
 
-int directed_graph::check_nest(int x, int y, set<edge_descriptor> &se)
+int directed_graph::check_nest(int x, int y, SE &se)
 {
 	vector<int> v = topological_sort();
 	vector<int> tpo;
@@ -646,7 +646,7 @@ int directed_graph::check_nest(int x, int y, set<edge_descriptor> &se)
 	return check_nest(x, y, se, tpo);
 }
 
-int directed_graph::check_nest(int x, int y, set<edge_descriptor> &se, const vector<int> &tpo)
+int directed_graph::check_nest(int x, int y, SE &se, const vector<int> &tpo)
 {
 	vector<int> rv;
 	bfs_reverse(y, rv);
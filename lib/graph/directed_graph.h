@@ -39,8 +39,8 @@ public:
 	// algorithms
 	virtual int bfs_reverse(int t, vector<int> &v);
 	virtual int bfs_reverse(int t, vector<int> &v, vector<int> &b);
-	virtual int bfs_reverse(int t, set<edge_descriptor> &ss);
-	virtual bool bfs_reverse(const vector<int> &vt, int s, const set<edge_descriptor> &fb);
+	virtual int bfs_reverse(int t, SE &ss);
+	virtual bool bfs_reverse(const vector<int> &vt, int s, const SE &fb);
 	virtual bool compute_shortest_path(int x, int y, vector<int> &p);
 	virtual bool compute_shortest_path(edge_descriptor ex, edge_descriptor ey, vector<int> &p);
 	virtual bool check_path(int x, int y);
@@ -53,8 +53,8 @@ public:
 	// virtual int compute_out_partner(int x);
 	virtual int compute_in_equivalent_vertex(int x);
 	virtual int compute_out_equivalent_vertex(int x);
-	virtual int check_nest(int x, int r, set<edge_descriptor> &vv);
-	virtual int check_nest(int x, int r, set<edge_descriptor> &vv, const vector<int> &tpo);
+	virtual int check_nest(int x, int r, SE &vv);
+	virtual int check_nest(int x, int r, SE &vv, const vector<int> &tpo);
 	virtual int check_nest(int x, int r, const vector<int> &tpo);
 
 	// draw
@@ -6,11 +6,14 @@ See LICENSE for licensing.
 
 #include "edge_base.h"
 #include <cstdio>
+#include <atomic>
 
 using namespace std;
 
+static atomic<uint64_t> edge_serial(0);
+
 edge_base::edge_base(int _s, int _t)
-	:s(_s), t(_t)
+	:s(_s), t(_t), serial(edge_serial++)
 {}
 
 int edge_base::move(int x, int y)
@@ -9,6 +9,8 @@ See LICENSE for licensing.
 
 #include <set>
 #include <map>
+#include <stdint.h>
+#include <cstddef>
 
 using namespace std;
 
@@ -23,6 +25,9 @@ protected:
 	int s;					// source
 	int t;					// target
 
+public:
+	uint64_t serial;		// creation order, see edge_less
+
 public:
 	virtual int move(int x, int y);
 	virtual int swap();
@@ -31,11 +36,22 @@ public:
 	virtual int print() const;
 };
 
+// orders edges by creation instead of by address, so that iterating over edges does not depend on the allocator
+struct edge_less
+{
+	bool operator()(const edge_base *x, const edge_base *y) const
+	{
+		if(x == NULL || y == NULL) return x < y;
+		return x->serial < y->serial;
+	}
+};
+
 typedef edge_base* edge_descriptor;
-typedef set<edge_base*>::iterator edge_iterator;
+typedef set<edge_base*, edge_less> SE;
+typedef SE::iterator edge_iterator;
 typedef pair<edge_descriptor, bool> PEB;
 typedef pair<edge_descriptor, edge_descriptor> PEE;
-typedef map<edge_descriptor, edge_descriptor> MEE;
+typedef map<edge_descriptor, edge_descriptor, edge_less> MEE;
 typedef pair<edge_iterator, edge_iterator> PEEI;
 
 #endif
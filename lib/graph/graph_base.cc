@@ -74,8 +74,10 @@ int graph_base::clear()
 	{
 		delete (*it);
 	}
+	for(int i = 0; i < retired.size(); i++) delete retired[i];
 	vv.clear();
 	se.clear();
+	retired.clear();
 	return 0;
 }
 
@@ -192,7 +194,7 @@ int graph_base::get_edge_indices(VE &i2e, MEI &e2i)
 	return 0;
 }
 
-bool graph_base::bfs(const vector<int> &vs, int t, const set<edge_descriptor> &fb)
+bool graph_base::bfs(const vector<int> &vs, int t, const SE &fb)
 {
 	set<int> closed(vs.begin(), vs.end());
 	vector<int> open = vs;
@@ -247,7 +249,7 @@ int graph_base::bfs(int s, vector<int> &v, vector<int> &b)
 	return 0;
 }
 
-int graph_base::bfs(int s, set<edge_descriptor> &ss)
+int graph_base::bfs(int s, SE &ss)
 {
 	ss.clear();
 	set<int> closed;
@@ -282,7 +284,7 @@ int graph_base::bfs(int t, vector<int> &v)
 
 bool graph_base::check_path(int s, int t) 
 {
-	set<edge_descriptor> fb;
+	SE fb;
 	vector<int> ss;
 	ss.push_back(s);
 	return bfs(ss, t, fb);
@@ -18,15 +18,14 @@ using namespace std;
 
 typedef map<int, string> MIS;
 typedef pair<int, string> PIS;
-typedef map<edge_descriptor, string> MES;
+typedef map<edge_descriptor, string, edge_less> MES;
 typedef pair<edge_descriptor, string> PES;
-typedef map<edge_descriptor, bool> MEB;
-typedef map<edge_descriptor, double> MED;
+typedef map<edge_descriptor, bool, edge_less> MEB;
+typedef map<edge_descriptor, double, edge_less> MED;
 typedef pair<edge_descriptor, double> PED;
-typedef map<edge_descriptor, int> MEI;
+typedef map<edge_descriptor, int, edge_less> MEI;
 typedef pair<edge_descriptor, int> PEI;
 typedef vector<edge_descriptor> VE;
-typedef set<edge_descriptor> SE;
 
 class graph_base
 {
@@ -37,7 +36,8 @@ public:
 
 protected:
 	vector<vertex_base*> vv;
-	set<edge_base*> se;
+	SE se;
+	vector<edge_base*> retired;		// removed edges, kept until clear() as they may still be keys (see edge_less)
 
 public:
 	// modify the graph
@@ -66,8 +66,8 @@ public:
 	// algorithms
 	virtual int bfs(int s, vector<int> &v);
 	virtual int bfs(int s, vector<int> &v, vector<int> &b);
-	virtual int bfs(int s, set<edge_descriptor> &ss);
-	virtual bool bfs(const vector<int> &vs, int t, const set<edge_descriptor> &fb);
+	virtual int bfs(int s, SE &ss);
+	virtual bool bfs(const vector<int> &vs, int t, const SE &fb);
 	virtual bool check_path(int s, int t);
 	virtual bool compute_shortest_path(int s, int t, vector<int> &p);
 	// virtual bool check_nested();
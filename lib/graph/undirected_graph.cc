@@ -50,8 +50,8 @@ int undirected_graph::remove_edge(edge_descriptor e)
 	if(se.find(e) == se.end()) return -1;
 	vv[e->source()]->remove_out_edge(e);
 	vv[e->target()]->remove_out_edge(e);
-	delete e;
 	se.erase(e);
+	retired.push_back(e);
 	return 0;
 }
 
@@ -19,8 +19,8 @@ public:
 	virtual ~vertex_base();
 
 protected:
-	set<edge_base*> si;		// in_edges
-	set<edge_base*> so;		// out_edges
+	SE si;		// in_edges
+	SE so;		// out_edges
 
 public:
 	virtual int add_in_edge(edge_base *e);
@@ -13,15 +13,18 @@ See LICENSE for licensing.
 #include <sstream>
 #include <algorithm>
 #include <map>
+#include <cctype>
 #include "util.h"
 #include "transcript.h"
 #include "src/config.h"
 
 transcript::transcript()
+	: ichash(0)
 {
 }
 
 transcript::transcript(const item &e)
+	: ichash(0)
 {
 	throw "transcript::transcript should not be constructed with an item object";
 	assign(e);
@@ -71,6 +74,7 @@ int transcript::clear()
 {
 	exons.clear();
 	as_exons.clear();
+	ichash = 0;
 	seqname = "";
 	source = "";
 	feature = "";
@@ -94,6 +98,7 @@ int transcript::add_exon(as_pos32 s, as_pos32 t)
 	assert(s.ale == "$");
 	assert(t.ale == "$");
 	exons.push_back(PI32(s, t));
+	ichash = 0;
 	return 0;
 }
 
@@ -116,6 +121,7 @@ int transcript::sort()
 {
 	std::sort(exons.begin(), exons.end());
 	std::sort(as_exons.begin(), as_exons.end());
+	ichash = 0;
 	return 0;
 }
 
@@ -147,6 +153,7 @@ int transcript::shrink()
 	}
 	v.push_back(p);
 	exons = v;
+	ichash = 0;
 	return 0;
 }
 
@@ -190,7 +197,7 @@ int transcript::assign_gt(genotype g)
 *	transform gt and as_exon
 *	@return	!gt_explicit_same(this->gt, g)
 */
-bool transcript::transform_gt(genotype g)
+bool transcript::transform_gt(genotype g, const vcf_data *vcf)
 {	
 	if(gt_explicit_same(gt, g)) return true;
 	
@@ -209,9 +216,13 @@ bool transcript::transform_gt(genotype g)
 		int p = a.first.p32;
 		int q = a.second.p32;
 		string s = "$";
-		for(const auto & string_gt_pair: asp.vcf_pos_map[seqname][p])
+		const map<string, genotype> *alleles = (vcf == NULL) ? NULL : vcf->get_alleles(seqname, p);		// read-only, shared by all workers
+		if(alleles != NULL)
 		{
-			if(string_gt_pair.second == g) s = string_gt_pair.first;
+			for(const auto & string_gt_pair: *alleles)
+			{
+				if(string_gt_pair.second == g) s = string_gt_pair.first;
+			}
 		}
 		as_pos32 p2(p, s);
 		as_pos32 q2(q, s);
@@ -248,6 +259,7 @@ vector<PI32> transcript::get_intron_chain() const
 size_t transcript::get_intron_chain_hashing() const
 {
 	if(exons.size() == 0) return 0;
+	if(ichash != 0) return ichash;
 
 	if(exons.size() == 1)
 	{
@@ -256,7 +268,8 @@ size_t transcript::get_intron_chain_hashing() const
 		vv.push_back(as_pos32{-2, "SingleExon"});
 		vv.push_back(exons[0].first);
 		vv.push_back(exons[0].second);
-		return vector_hash(vv) + 1;
+		ichash = vector_hash(vv) + 1;
+		return ichash;
 	}
 
 	vector<as_pos32> vv;
@@ -266,7 +279,8 @@ size_t transcript::get_intron_chain_hashing() const
 		vv.push_back(v[i].first);
 		vv.push_back(v[i].second);
 	}
-	return vector_hash(vv) + 1;
+	ichash = vector_hash(vv) + 1;
+	return ichash;
 }
 
 int transcript::intron_chain_compare(const transcript &t) const
@@ -340,66 +354,98 @@ int transcript::extend_bounds(const transcript &t)
 	if(exons.size() == 0) return 0;
 	if(t.exons.front().first < exons.front().first) exons.front().first = t.exons.front().first;
 	if(t.exons.back().second > exons.back().second) exons.back().second = t.exons.back().second;
+	ichash = 0;
 	return 0;
 }
 
 int transcript::write(ostream &fout, double cov2, int count) const
 {
-	fout.precision(4);
-	fout<<fixed;
+	string s;
+	format(s, cov2, count);
+	fout << s;
+	return 0;
+}
+
+int transcript::write_gvf(ostream &fout, double cov2, int count) const
+{
+	string s;
+	format_gvf(s, cov2, count);
+	fout << s;
+	return 0;
+}
+
+// the 8 leading gtf columns, with a score of 1000 and no frame
+static int format_columns(string &s, const string &seqname, const string &source, const char *feature, int32_t l, int32_t r, char strand)
+{
+	s += seqname;
+	s += '\t';
+	s += source;
+	s += '\t';
+	s += feature;
+	s += '\t';
+	append_int(s, l);
+	s += '\t';
+	append_int(s, r);
+	s += "\t1000\t";
+	s += strand;
+	s += "\t.\t";
+	return 0;
+}
+
+static int format_attribute(string &s, const char *key, const string &value)
+{
+	s += key;
+	s += " \"";
+	s += value;
+	s += "\"; ";
+	return 0;
+}
 
+int transcript::format(string &s, double cov2, int count) const
+{
 	if(exons.size() == 0) return 0;
 	
 	PI32 p = get_bounds();
 
-	fout	<<	seqname.c_str()		<<"\t";										// chromosome name
-	fout	<<	source.c_str()		<<"\t";										// source
-	fout	<<	"transcript"		<<"\t";										// feature
-	fout	<<	p.first.p32 + 1		<<"\t";										// left position; 0-based to 1-based by adding 1
-	fout	<<	p.second.p32 		<<"\t";										// right position
-	fout	<<	1000				<<"\t";										// score, now as expression
-	fout	<<	strand				<<"\t";										// strand
-	fout	<<	"."					<<"\t";															// frame
-	fout	<<	"gene_id \""		<<	gene_id.c_str()				<<"\"; ";
-	fout	<<	"transcript_id \""	<<	transcript_id.c_str()		<<"\"; ";
-	if(gene_type != "") 
-		fout<<	"gene_type \""		<<	gene_type.c_str()			<<"\"; ";
-	if(transcript_type != "") 
-		fout<<"transcript_type \""	<<	transcript_type.c_str()		<<"\"; ";
+	format_columns(s, seqname, source, "transcript", p.first.p32 + 1, p.second.p32, strand);	// 0-based to 1-based by adding 1
+	format_attribute(s, "gene_id", gene_id);
+	format_attribute(s, "transcript_id", transcript_id);
+	if(gene_type != "") format_attribute(s, "gene_type", gene_type);
+	if(transcript_type != "") format_attribute(s, "transcript_type", transcript_type);
 	
-	//fout<<"RPKM \""<<RPKM<<"\"; ";
-	fout	<<	"cov \""			<<	coverage					<<"\"; ";
+	s += "cov \"";
+	append_fixed(s, coverage, 4);
+	s += "\"; ";
 
-	if(cov2 >= -0.5) 
-		fout<<	"cov2 \""			<<	cov2						<<"\"; ";
+	if(cov2 >= -0.5)
+	{
+		s += "cov2 \"";
+		append_fixed(s, cov2, 4);
+		s += "\"; ";
+	}
 	
 	if(count >= -0.5) 
-		fout<<	"count \""			<<	count						<<"\"; ";
-	
-	fout 	<< 	endl;
+	{
+		s += "count \"";
+		append_int(s, count);
+		s += "\"; ";
+	}
+	s += '\n';
 
 	for(int k = 0; k < exons.size(); k++)
 	{
-		fout<<seqname.c_str()<<"\t";		// chromosome name
-		fout<<source.c_str()<<"\t";			// source
-		fout<<"exon\t";						// feature
-		fout<<exons[k].first.p32 + 1<<"\t";		// left position; 0-based to 1-based by adding 1
-		fout<<exons[k].second.p32<<"\t";		// right position
-		fout<<1000<<"\t";					// score, now as expression
-		fout<<strand<<"\t";					// strand
-		fout<<".\t";						// frame
-		fout<<"gene_id \""<<gene_id.c_str()<<"\"; ";
-		fout<<"transcript_id \""<<transcript_id.c_str()<<"\"; ";
-		fout<<"exon \""<<k + 1<<"\"; "<<endl;
+		format_columns(s, seqname, source, "exon", exons[k].first.p32 + 1, exons[k].second.p32, strand);
+		format_attribute(s, "gene_id", gene_id);
+		format_attribute(s, "transcript_id", transcript_id);
+		s += "exon \"";
+		append_int(s, k + 1);
+		s += "\"; \n";
 	}
 	return 0;
 }
 
-int transcript::write_gvf(ostream &fout, double cov2, int count) const
+int transcript::format_gvf(string &s, double cov2, int count) const
 {
-	fout.precision(4);
-	fout<<fixed;
-
 	if(exons.size() == 0) return 0;
 	vector<PI32> exons_and_as_exons(exons);
 	exons_and_as_exons.insert(exons_and_as_exons.end(), as_exons.begin(), as_exons.end());
@@ -407,137 +453,128 @@ int transcript::write_gvf(ostream &fout, double cov2, int count) const
 
 	PI32 p = get_bounds();
 
-	fout<<seqname.c_str()<<"\t";				// chromosome name
-	fout<<source.c_str()<<"\t";					// source
-	fout<<"transcript\t";						// feature
-	fout<<p.first.p32 + 1<<"\t";					// left position
-	fout<<p.second.p32 <<"\t";						// right position
-	fout<<1000<<"\t";							// score, now as expression
-	fout<<strand<<"\t";							// strand
-	fout<<".\t";								// frame
-	fout<<"gene_id \""<<gene_id.c_str()<<"\"; ";
-	fout<<"transcript_id \""<<transcript_id.c_str()<<"\"; ";
-	fout<<"allele \""<< gt_str(gt) <<"\"; ";
-	if(gene_type != "") fout<<"gene_type \""<<gene_type.c_str()<<"\"; ";
-	if(transcript_type != "") fout<<"transcript_type \""<<transcript_type.c_str()<<"\"; ";
-	//fout<<"RPKM \""<<RPKM<<"\"; ";
-	fout<<"cov \""<<coverage<<"\"; ";
-	if(cov2 >= -0.5) fout<<"cov2 \""<<cov2<<"\"; ";
-	if(count >= -0.5) fout<<"count \""<<count<<"\"; ";
-	fout << endl;
+	format_columns(s, seqname, source, "transcript", p.first.p32 + 1, p.second.p32, strand);
+	format_attribute(s, "gene_id", gene_id);
+	format_attribute(s, "transcript_id", transcript_id);
+	format_attribute(s, "allele", gt_str(gt));
+	if(gene_type != "") format_attribute(s, "gene_type", gene_type);
+	if(transcript_type != "") format_attribute(s, "transcript_type", transcript_type);
+
+	s += "cov \"";
+	append_fixed(s, coverage, 4);
+	s += "\"; ";
+	if(cov2 >= -0.5)
+	{
+		s += "cov2 \"";
+		append_fixed(s, cov2, 4);
+		s += "\"; ";
+	}
+	if(count >= -0.5)
+	{
+		s += "count \"";
+		append_int(s, count);
+		s += "\"; ";
+	}
+	s += '\n';
 
 	for(int k = 0, exon_num = 0; k < exons_and_as_exons.size(); k++)
 	{
-		fout<<seqname.c_str()<<"\t";		// chromosome name
-		fout<<source.c_str()<<"\t";			// source
-		
-		string a = exons_and_as_exons[k].first.ale;
-		if (a == "$") 
+		const string &a = exons_and_as_exons[k].first.ale;
+		if(a == "$") exon_num ++;
+
+		format_columns(s, seqname, source, a == "$" ? "exon" : "variant", exons_and_as_exons[k].first.p32 + 1, exons_and_as_exons[k].second.p32, strand);
+		format_attribute(s, "gene_id", gene_id);
+		format_attribute(s, "transcript_id", transcript_id);
+		s += "exon \"";
+		append_int(s, exon_num);
+		s += "\"; ";
+		if(a != "$") 
 		{
-			fout<<"exon\t";						// feature
-			exon_num ++;
+			format_attribute(s, "seq", a);
+			format_attribute(s, "allele", gt_str(gt));
 		}
-		else 
-		{
-			fout<<"variant\t";	
-		}
-		fout<<exons_and_as_exons[k].first.p32 + 1<<"\t";		// left position
-		fout<<exons_and_as_exons[k].second.p32<<"\t";		// right position
-		fout<<1000<<"\t";					// score, now as expression
-		fout<<strand<<"\t";					// strand
-		fout<<".\t";						// frame
-		fout<<"gene_id \""<<gene_id.c_str()<<"\"; ";
-		fout<<"transcript_id \""<<transcript_id.c_str()<<"\"; ";
-		fout<<"exon \""<<exon_num <<"\"; ";
-		if (a != "$") 
-		{
-			fout<<"seq \""<<a.c_str()<<"\"; ";
-			fout<<"allele \""<< gt_str(gt) <<"\"; ";
-		}
-		fout<<endl;
+		s += '\n';
 	}
 	return 0;
 }
 
 int transcript::write_fasta(ostream &fout, int line_len, faidx_t *fai) const
 {
-	assert(0 && "Not implemented");		// TODO: pull sequences from genome fasta, replace allele
+	if(exons.size() == 0) return 0;
 
+	PI32 p = get_bounds();
+	int len = 0;
+	char *x = faidx_fetch_seq(fai, seqname.c_str(), p.first.p32, p.second.p32 - 1, &len);	// both [seq_begin, seq_end] included; both exons and fai are 0-based
+	string ref = (x == NULL) ? "" : string(x, len);
+	free(x);
+	for(int i = 0; i < ref.size(); i++) ref[i] = toupper(ref[i]);
+
+	string s;
+	format_fasta(s, line_len, ref, p.first.p32);
+	fout << s;
+	return 0;
+}
 
-	if(exons.size() == 0) return 0;
-		
-	string sequence;
-	for(int k = 0; k < exons.size(); ++k)
+// reference of [p, q), 'N' outside of the window ref of [ref_lpos, ref_lpos + ref.size())
+static int append_reference(string &seq, const string &ref, int32_t ref_lpos, int32_t p, int32_t q)
+{
+	for(int32_t k = p; k < q; k++)
 	{
-		assert(exons[k].first.ale == "$");
-		assert(exons[k].second.ale == "$");
-		int seqlen;
-		char* s = faidx_fetch_seq(fai, seqname.c_str(), exons[k].first.p32, exons[k].second.p32-1, &seqlen);	//both [seq_begin, seq_end] included; both exons and fai are 0-based
-		sequence += s;
-		free(s);	
+		int32_t j = k - ref_lpos;
+		seq += (j >= 0 && j < ref.size()) ? ref[j] : 'N';
 	}
+	return 0;
+}
 
-	// int k = 0;
-	// int i = 0;
-	// while(i < as_exons.size() && k < exons.size())
-	// {
-	// 	int p1 = as_exons[i].first.p32;
-	// 	int p2 = as_exons[i].second.p32;
-	// 	int q1 = exons[k].first.p32;
-	// 	int q2 = exons[k].second.p32;
-		
-	// 	if() 
-	// 	{
-			
-	// 	}
-	// 	else if ()
-	// 	{
-
-	// 	}
-		
+int transcript::format_fasta(string &s, int line_len, const string &ref, int32_t ref_lpos) const
+{
+	if(exons.size() == 0) return 0;
 
-	// 	assert(k >= 1);
-	// 	assert(exons[k].first.ale != "$")
-	// 	assert(exons[k].first.ale == exons[k].second.ale);
-	// 	assert(exons[k].first.rightsameto(exons[k-1].first));
-	// 	int l = sequence.length();
-	// 	string ale = exons[k].first.ale;
-	// 	int exon_len = exons[k-1].second.p32 - exons[k-1].first.p32;
-	// 	int p = l - exon_len + (exons[k].first.p32 - exons[k-1].first.p32);
-	// 	int as_len = exons[k].second.p32 - exons[k].first.p32;
-	// 	sequence.replace(p, as_len, exons[k].first.ale);
-
-	// 	i ++;
-	// }
-	// if(i < as_exons.size())
-	// {
-
-	// }
-
-
-	// string rc;
-	// reverse_complement_DNA(rc, sequence);
-	// if (strand == "-")
-	// {
-	// }
-	// else if (strand == '.'){	//TODO: use both
-	// }
-	// else 
-	// {
-	// 	assert (strand == '+'); 	//trand must be one of ./+/- 
-	// }
-
-
-	string name = transcript_id;	
-
-	fout << ">" << name << endl;
+	// splice the exons, replacing the reference by the allele of each as_exon ("$" and "n" keep the reference)
+	string seq;
 	int i = 0;
-	for(; i < sequence.length() / line_len; ++i)  fout << sequence.substr(line_len * i, line_len) << endl;
-	fout << sequence.substr(line_len * i, sequence.length() - line_len * i) << endl;
+	for(int k = 0; k < exons.size(); k++)
+	{
+		int32_t p = exons[k].first.p32;
+		int32_t q = exons[k].second.p32;
+		while(p < q)
+		{
+			while(i < as_exons.size() && as_exons[i].second.p32 <= p) i++;
+
+			int32_t e = q;
+			if(i < as_exons.size() && as_exons[i].first.p32 < q) e = max(p, as_exons[i].first.p32);
+			append_reference(seq, ref, ref_lpos, p, e);
+			p = e;
+			if(p >= q || i >= as_exons.size()) continue;
+
+			const string &a = as_exons[i].first.ale;
+			int32_t r = min(q, as_exons[i].second.p32);
+			if(a == "$" || a == "n") append_reference(seq, ref, ref_lpos, p, r);
+			else seq += a;
+			p = r;
+			i++;
+		}
+	}
+
+	if(strand == '-')
+	{
+		string rc;
+		reverse_complement_DNA(rc, seq);
+		seq = rc;
+	}
+
+	s += '>';
+	s += transcript_id;
+	s += '\n';
+	if(line_len <= 0) line_len = seq.size();
+	for(int k = 0; k < seq.size(); k += line_len)
+	{
+		s.append(seq, k, line_len);
+		s += '\n';
+	}
 	return 0;	
 }
 
-
 int transcript::reverse_complement_DNA(string &rc, const string s)
 {
 	char c;
@@ -57,6 +57,7 @@ public:
 
 	vector<PI32> exons;
 	vector<PI32> as_exons;
+	mutable size_t ichash;		// cached get_intron_chain_hashing(), 0 if not computed; reset when exons change
 
 public:
 	int add_exon(as_pos32 s, as_pos32 t);
@@ -70,7 +71,7 @@ public:
 	int length() const;
 	int make_non_specific();
 	int assign_gt(genotype g);
-	bool transform_gt(genotype g);
+	bool transform_gt(genotype g, const vcf_data *vcf);		// alleles of g from vcf, "$" if NULL
 	PI32 get_bounds() const;
 	// PI32 get_first_intron() const;
 	size_t get_intron_chain_hashing() const;
@@ -83,7 +84,10 @@ public:
 	// string label() const;
 	int write(ostream &fout, double cov2 = -1, int count = -1) const;
 	int write_gvf(ostream &fout, double cov2 = -1, int count = -1) const;
+	int format(string &s, double cov2 = -1, int count = -1) const;		// appends the gtf lines to s
+	int format_gvf(string &s, double cov2 = -1, int count = -1) const;	// appends the gvf lines to s
 	int write_fasta(ostream &fout, int line_len, faidx_t *fai) const;
+	int format_fasta(string &s, int line_len, const string &ref, int32_t ref_lpos) const;	// ref starts at ref_lpos
 
 	
 
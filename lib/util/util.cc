@@ -6,6 +6,8 @@ See LICENSE for licensing.
 
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <chrono>
 #include "util.h"
 
 string toupperstring(const string s)
@@ -29,7 +31,7 @@ vector<string> split(const string s, const string sep)
 		v.push_back(s2.substr(0, delim_pos));
 		s2.erase(0, delim_pos + sep.length()); //also remove sep
 	}
-	v.push_back(s);
+	v.push_back(s2);
 	return v;
 }
 
@@ -66,6 +68,10 @@ size_t vector_hash(const vector<as_pos32> & vec)
 	return (seed & 0x7FFFFFFF);
 }
 
+double wall_clock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 // reverse-complement DNA sequence w. IUPAC symbols
 int reverse_complement_DNA(string &rc, const string s)
@@ -130,4 +136,83 @@ int reverse_complement_DNA(string &rc, const string s)
 		rc += c;
 	}
 	return 0;
-}
\ No newline at end of file
+}
+
+int write_binary(ostream &fout, const string &s)
+{
+	uint32_t n = s.size();
+	write_binary(fout, n);
+	fout.write(s.data(), n);
+	return 0;
+}
+
+bool read_binary(istream &fin, string &s)
+{
+	uint32_t n = 0;
+	if(read_binary(fin, n) == false) return false;
+	s.resize(n);
+	if(n >= 1) fin.read(&s[0], n);
+	return fin.good();
+}
+
+int append_int(string &s, int64_t x)
+{
+	char buf[24];
+	int n = 0;
+	uint64_t u = (x < 0) ? (0 - (uint64_t)(x)) : x;
+	do
+	{
+		buf[n++] = '0' + (u % 10);
+		u /= 10;
+	}
+	while(u > 0);
+	if(x < 0) s += '-';
+	while(n > 0) s += buf[--n];
+	return 0;
+}
+
+// values close to a rounding tie, and large or non-finite values, are left to snprintf
+int append_fixed(string &s, double x, int digits)
+{
+	static const int64_t scale[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+	double y = (std::isfinite(x) && digits >= 0 && digits <= 6) ? fabs(x) * scale[digits] : -1;
+	double f = floor(y);
+	if(y < 0 || y >= 1e9 || fabs(y - f - 0.5) < 1e-6)
+	{
+		char buf[512];
+		snprintf(buf, sizeof(buf), "%.*f", digits, x);
+		s += buf;
+		return 0;
+	}
+
+	int64_t v = (int64_t)(f) + (y - f > 0.5 ? 1 : 0);
+	if(signbit(x)) s += '-';
+	append_int(s, v / scale[digits]);
+	if(digits == 0) return 0;
+
+	s += '.';
+	int64_t r = v % scale[digits];
+	for(int64_t k = scale[digits] / 10; k > r && k > 1; k /= 10) s += '0';
+	append_int(s, r);
+	return 0;
+}
+
+// splitmix64 finalizer
+static uint64_t mix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+uint64_t task_seed(uint64_t seed, int64_t a, int64_t b, int64_t c, int64_t d)
+{
+	uint64_t x = mix64(seed);
+	x = mix64(x ^ (uint64_t)(a));
+	x = mix64(x ^ (uint64_t)(b));
+	x = mix64(x ^ (uint64_t)(c));
+	x = mix64(x ^ (uint64_t)(d));
+	return x;
+}
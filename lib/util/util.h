@@ -101,6 +101,66 @@ int min_element(const vector<T> &x)
 	return k;
 }
 
+// stable LSD radix sort of x on the unsigned key(x[i]), 8 bits per pass;
+// passes over a byte that is identical for all keys are skipped
+template<typename T>
+int radix_sort(vector<T> &x, uint64_t (*key)(const T &))
+{
+	if(x.size() <= 1) return 0;
+
+	uint64_t any = 0, all = ~((uint64_t)0);
+	for(int i = 0; i < x.size(); i++)
+	{
+		any |= key(x[i]);
+		all &= key(x[i]);
+	}
+
+	vector<T> y(x.size());
+	for(int b = 0; b < 64; b += 8)
+	{
+		if((((any ^ all) >> b) & 0xff) == 0) continue;
+
+		size_t cnt[257] = {0};
+		for(int i = 0; i < x.size(); i++) cnt[((key(x[i]) >> b) & 0xff) + 1]++;
+		for(int d = 0; d < 256; d++) cnt[d + 1] += cnt[d];
+		for(int i = 0; i < x.size(); i++) y[cnt[(key(x[i]) >> b) & 0xff]++] = x[i];
+		x.swap(y);
+	}
+	return 0;
+}
+
+// index of the first element of sorted x[k1, k2) that is not less than v, or k2;
+// the search halves the range with a conditional move instead of a branch
+template<typename T>
+int lower_bound_index(const vector<T> &x, int k1, int k2, const T &v)
+{
+	if(k1 >= k2) return k2;
+	const T *base = x.data() + k1;
+	int n = k2 - k1;
+	while(n > 1)
+	{
+		int h = n / 2;
+		base = (base[h] < v) ? base + h : base;
+		n -= h;
+	}
+	return (base - x.data()) + (*base < v ? 1 : 0);
+}
+
+// raw binary I/O of trivially copyable values and of strings, used by capture files
+template<typename T>
+int write_binary(ostream &fout, const T &x)
+{
+	fout.write((const char*)(&x), sizeof(T));
+	return 0;
+}
+
+template<typename T>
+bool read_binary(istream &fin, T &x)
+{
+	fin.read((char*)(&x), sizeof(T));
+	return fin.good();
+}
+
 template<typename T>
 int prints(const set<T> &x)
 {
@@ -190,6 +250,12 @@ size_t string_hash(const std::string& str);
 // size_t vector_hash(const vector<int32_t> &str);
 size_t vector_hash(const vector<as_pos32> &str);
 int reverse_complement_DNA(string &rc, const string s);
+double wall_clock();							// seconds on a monotonic clock
+int write_binary(ostream &fout, const string &s);
+bool read_binary(istream &fin, string &s);
+uint64_t task_seed(uint64_t seed, int64_t a, int64_t b = 0, int64_t c = 0, int64_t d = 0);	// independent stream per task
+int append_int(string &s, int64_t x);					// as printf("%ld")
+int append_fixed(string &s, double x, int digits);		// as printf("%.*f")
 
 class BundleError					// TODO: tmp DEBUG helper
 {
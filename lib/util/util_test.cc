@@ -0,0 +1,86 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+/*
+**	util_test: append_int and append_fixed against printf, run by `make check`
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "util.h"
+
+static int failures = 0;
+
+static int check_fixed(double x, int digits)
+{
+	char buf[512];
+	snprintf(buf, sizeof(buf), "%.*f", digits, x);
+	string s = "prefix";
+	append_fixed(s, x, digits);
+	if(s == "prefix" + string(buf)) return 0;
+	printf("append_fixed(%.17g, %d) = %s, printf gives %s\n", x, digits, s.c_str() + 6, buf);
+	failures++;
+	return -1;
+}
+
+static int check_int(int64_t x)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%lld", (long long)x);
+	string s;
+	append_int(s, x);
+	if(s == buf) return 0;
+	printf("append_int(%lld) = %s\n", (long long)x, s.c_str());
+	failures++;
+	return -1;
+}
+
+int main()
+{
+	vector<double> v;
+
+	// non-finite values
+	v.push_back(numeric_limits<double>::quiet_NaN());
+	v.push_back(-numeric_limits<double>::quiet_NaN());
+	v.push_back(numeric_limits<double>::infinity());
+	v.push_back(-numeric_limits<double>::infinity());
+
+	// zeros, small and large values, negatives
+	double w[] = {0.0, -0.0, 1e-9, -1e-9, 0.001, -0.001, 0.004999, -0.004999, 1.0, -1.0, 3.14159, -3.14159,
+		99.999, -99.999, 123456.789, -123456.789, 999999999.0, 1e12, -1e12, 1.7976931348623157e308};
+	for(int i = 0; i < sizeof(w) / sizeof(w[0]); i++) v.push_back(w[i]);
+
+	// rounding ties, exact in binary or not
+	double t[] = {0.5, 1.5, 2.5, -0.5, -2.5, 0.125, 0.375, -0.625, 0.005, 0.015, 0.025, 1.005, 2.675, -2.675, 1.0005, 0.45, 0.55};
+	for(int i = 0; i < sizeof(t) / sizeof(t[0]); i++) v.push_back(t[i]);
+
+	// values at and around k / 10^d + 0.5 / 10^d
+	for(int k = 0; k < 1000; k++)
+	{
+		double x = (k + 0.5) / 100.0;
+		v.push_back(x);
+		v.push_back(-x);
+		v.push_back(nextafter(x, 0.0));
+		v.push_back(nextafter(x, 1e9));
+	}
+
+	mt19937_64 rng(42);
+	uniform_real_distribution<double> u(-1e6, 1e6);
+	for(int k = 0; k < 100000; k++) v.push_back(u(rng));
+
+	for(int i = 0; i < v.size(); i++)
+	{
+		for(int d = 0; d <= 7; d++) check_fixed(v[i], d);
+	}
+
+	int64_t z[] = {0, 1, -1, 9, 10, -10, 123456789, -987654321, numeric_limits<int64_t>::max(), numeric_limits<int64_t>::min()};
+	for(int i = 0; i < sizeof(z) / sizeof(z[0]); i++) check_int(z[i]);
+
+	if(failures > 0) printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
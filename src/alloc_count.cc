@@ -0,0 +1,28 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+/*
+** the global operator new that counts allocations for the per-stage statistics (--stats-json);
+** linked into the altai and altai_bench binaries only, so that libaltai leaves the allocator of its host alone
+*/
+
+#include <cstdlib>
+#include <new>
+
+#include "run_stats.h"
+
+void* operator new(size_t n)
+{
+	run_stats::count_allocation();
+	void *p = malloc(n == 0 ? 1 : n);
+	if(p == NULL) throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
@@ -0,0 +1,21 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include "altai.h"
+
+int assemble_region(const vector<bam1_t*> &reads, const string &chrm, const run_config &rc, vector< vector<transcript> > &v)
+{
+	run_config r = rc;
+	r.input_file = "";
+	r.output_file = "";
+	r.output_file1 = "";
+	r.fasta_file = "";
+
+	assembler asmb(r);
+	for(int i = 0; i < reads.size(); i++) asmb.add_read(reads[i], chrm);
+	asmb.assemble_reads(v);
+	return 0;
+}
@@ -0,0 +1,44 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __ALTAI_H__
+#define __ALTAI_H__
+
+/*
+**	interface of libaltai, for assembling in memory instead of from -i/-j files:
+**
+**		vcf_data variants;
+**		variants.add("chr1", 1234, "A", "A", "G");		// 0-based, GT 0|1
+**		run_config rc;									// parameters are the globals of config.h
+**		rc.vcf = &variants;
+**		rc.library_type = UNSTRANDED;					// not previewed: give library type and insert sizes
+**		rc.insertsize_median = 250;
+**		...
+**		vector< vector<transcript> > v;
+**		assemble_region(reads, "chr1", rc, v);
+**
+**	for a stream of reads, call assembler::add_read for each and assembler::assemble_reads at the end
+**	of each region; an assembler (with its vcf_data) is used by one thread at a time, several may run
+**	concurrently. v[0] holds the merged transcripts, v[1] and v[2] those of ALLELE1 and ALLELE2,
+**	with transcript::gt telling whether a transcript is specific to the allele (or NONSPECIFIC).
+*/
+
+#include <string>
+#include <vector>
+
+#include "htslib/sam.h"
+#include "config.h"
+#include "vcf_data.h"
+#include "run_context.h"
+#include "assembler.h"
+#include "transcript.h"
+
+using namespace std;
+
+// reads of one region on chrm, sorted by position; no file is read or written
+int assemble_region(const vector<bam1_t*> &reads, const string &chrm, const run_config &rc, vector< vector<transcript> > &v);
+
+#endif
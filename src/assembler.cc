@@ -15,6 +15,8 @@ See LICENSE for licensing.
 #include <iostream>
 #include <map>
 #include <cstring>
+#include <thread>
+#include <stdint.h>
 
 #include "config.h"
 #include "genome.h"
@@ -28,153 +30,251 @@ See LICENSE for licensing.
 #include "phaser.h"
 #include "util.h"
 #include "specific_trsts.hpp"
+#include "run_stats.h"
+#include "bundle_capture.h"
+#include "out_writer.h"
 
-assembler::assembler()
+assembler::assembler(const run_config &r)
+	: rc(r), wc(rc)
 {
-    sfn = sam_open(input_file.c_str(), "r");
-    hdr = sam_hdr_read(sfn);
+	sfn = NULL;
+	hdr = NULL;
+	if(rc.input_file != "")
+	{
+		sfn = sam_open(rc.input_file.c_str(), "r");
+		hdr = sam_hdr_read(sfn);
+	}
     b1t = bam_init1();
 	hid = 0;
 	index = 0;
+	stream_tid = -1;
+	num_written = 0;
+	to_collect = false;
+	collected.resize(3);
+	out_pool = NULL;
+	deadline = 0;
 	terminate = false;
 	qlen = 0;
 	qcnt = 0;
-	vmap_chrm = "";  // reset vcf pointers from previewer
 	trsts.resize(3);
 	nonfull_trsts.resize(3);
 	specific_full_trsts.resize(3);
+	blog.top_n = bundle_log_top;
+	if(bundle_log_graphs) blog.graph_prefix = bundle_log_file;
+
+	capture_lpos = 0;
+	capture_rpos = 0;
+	if(capture_file != "")
+	{
+		if(capture_region != "" && bundle_capture::parse_region(capture_region, capture_chrm, capture_lpos, capture_rpos) == false)
+		{
+			printf("error: invalid capture region %s\n", capture_region.c_str());
+			exit(0);
+		}
+		capture.open(capture_file.c_str(), ios::binary);
+		if(capture.fail()) printf("open file %s error\n", capture_file.c_str());
+		else bundle_capture::write_header(capture, rc);
+	}
 }
 
 assembler::~assembler()
 {
+	close_outputs();
     bam_destroy1(b1t);
-    bam_hdr_destroy(hdr);
-    sam_close(sfn);
-	fai_destroy(fai);
+    if(hdr != NULL) bam_hdr_destroy(hdr);
+    if(sfn != NULL) sam_close(sfn);
 }
 
 int assembler::assemble()
 {
+	open_outputs();
+
+	stage_timer rt(STAGE_READ);		// paused while bundles are processed
     while(sam_read1(sfn, hdr, b1t) >= 0)
 	{
-		if(terminate == true) return 0;
-
-		bam1_core_t &p = b1t->core;
-
-		if(p.tid < 0) continue;
-		if((p.flag & 0x4) >= 1) continue;										// read is not mapped
-		if((p.flag & 0x100) >= 1 && use_second_alignment == false) continue;	// secondary alignment
-		if(p.n_cigar > max_num_cigar) continue;									// ignore hits with more than max-num-cigar types
-		if(p.qual < min_mapping_quality) continue;								// ignore hits with small quality
-		if(p.n_cigar < 1) continue;												// should never happen
+		if(terminate == true) return finish();
+		if(b1t->core.tid < 0) continue;
 
+		read_hit(b1t, hdr->target_name[b1t->core.tid]);
 
-		char buf[1024];
-		strcpy(buf, hdr->target_name[p.tid]);
-
-		hit ht(b1t, string(buf), hid++);
-		ht.set_tags(b1t);
-		ht.set_strand();
-		
-		qlen += ht.qlen;
-		qcnt += 1;
-
-		// truncate
-		if(ht.tid != bb1.tid || ht.pos > bb1.rpos + min_bundle_gap)
-		{
-			if (bb1.hits.size() >= 1) pool.push_back(bb1);
-			bb1.clear();
-		}
-		if(ht.tid != bb2.tid || ht.pos > bb2.rpos + min_bundle_gap)
+		// process
+		if(pool.size() >= batch_bundle_size)
 		{
-			if(bb2.hits.size() >= 1) pool.push_back(bb2);
-			bb2.clear();
+			rt.stop();
+			process(batch_bundle_size);
+			rt.start();
 		}
-
-		// process
-		process(batch_bundle_size);
-
-		//printf("read strand = %c, xs = %c, ts = %c\n", ht.strand, ht.xs, ht.ts);
-
-		// add hit
-		if(uniquely_mapped_only == true && ht.nh != 1) continue;
-		if(library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') continue;
-		if(library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') continue;
-		if(library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
-		if(library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
-		if(library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '.') bb1.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '.') bb2.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '+') bb1.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '-') bb2.add_hit(ht);
 	}
 
+	rt.stop();
 	pool.push_back(bb1);
 	pool.push_back(bb2);
+	bb1.clear();
+	bb2.clear();
 	process(0);
 
-	assign_RPKM();
+	if(capture.is_open())
+	{
+		bundle_capture::write_footer(capture, qlen, qcnt);
+		capture.close();
+	}
 
-	if(DEBUG_MODE_ON && trsts[0].size() < 1 && trsts[1].size() < 1 && trsts[2].size() < 1) throw runtime_error("No AS transcript found!");
+	return finish();
+}
 
-	// filter each allele
-	/* for(int i = 0; i < 3; i++)
+// filters a read and adds it to the bundles of its strand; finished bundles are pooled
+int assembler::read_hit(bam1_t *b, const string &chrm)
+{
+	bam1_core_t &p = b->core;
+
+	if(p.tid < 0) return 0;
+	if((p.flag & 0x4) >= 1) return 0;										// read is not mapped
+	if((p.flag & 0x100) >= 1 && use_second_alignment == false) return 0;	// secondary alignment
+	if(p.n_cigar > max_num_cigar) return 0;									// ignore hits with more than max-num-cigar types
+	if(p.qual < min_mapping_quality) return 0;								// ignore hits with small quality
+	if(p.n_cigar < 1) return 0;												// should never happen
+
+	hit ht(b, chrm, hid++, wc);
+	ht.set_tags(b);
+	ht.set_strand(rc.library_type);
+	
+	qlen += ht.qlen;
+	qcnt += 1;
+	rstats.count(COUNT_READS, 1);
+
+	// truncate
+	if(ht.tid != bb1.tid || ht.pos > bb1.rpos + min_bundle_gap)
 	{
-		if (! use_filter) break;
+		if (bb1.hits.size() >= 1) pool.push_back(bb1);
+		bb1.clear();
+	}
+	if(ht.tid != bb2.tid || ht.pos > bb2.rpos + min_bundle_gap)
+	{
+		if(bb2.hits.size() >= 1) pool.push_back(bb2);
+		bb2.clear();
+	}
 
-		filter ft(trsts[i]);
-		ft.merge_single_exon_transcripts();
-		trsts[i] = ft.trs;
+	//printf("read strand = %c, xs = %c, ts = %c\n", ht.strand, ht.xs, ht.ts);
+
+	// add hit
+	if(uniquely_mapped_only == true && ht.nh != 1) return 0;
+	if(rc.library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') return 0;
+	if(rc.library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') return 0;
+	if(rc.library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
+	if(rc.library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
+	if(rc.library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
+	if(rc.library_type == UNSTRANDED && ht.xs == '.') bb1.add_hit(ht);
+	if(rc.library_type == UNSTRANDED && ht.xs == '.') bb2.add_hit(ht);
+	if(rc.library_type == UNSTRANDED && ht.xs == '+') bb1.add_hit(ht);
+	if(rc.library_type == UNSTRANDED && ht.xs == '-') bb2.add_hit(ht);
+	return 0;
+}
 
-		filter ft1(nonfull_trsts[i]);
-		ft1.merge_single_exon_transcripts();
-		nonfull_trsts[i] = ft1.trs;
-	}	 */
+// in-memory use: reads of one or more regions, sorted by position, are assembled by assemble_reads
+int assembler::add_read(bam1_t *b, const string &chrm)
+{
+	to_collect = true;
+	read_hit(b, chrm);
+	process(batch_bundle_size);
+	return 0;
+}
 
-	// get specific trsts
-	specific_full_trsts.clear();
+// v[0]: merged, v[1]: ALLELE1, v[2]: ALLELE2, as written to the output files
+int assembler::assemble_reads(vector< vector<transcript> > &v)
+{
+	to_collect = true;
+	pool.push_back(bb1);
+	pool.push_back(bb2);
+	bb1.clear();
+	bb2.clear();
+	process(0);
+	flush_outputs();
+	stream_tid = -1;
 
-	for(transcript t: trsts[1])
+	v.swap(collected);
+	collected.clear();
+	collected.resize(3);
+	return terminate ? -1 : 0;
+}
+
+// assemble the bundles of a capture file, replay_rounds times, and write the transcripts of the last round
+int assembler::replay(const string &file)
+{
+	ifstream fin(file.c_str(), ios::binary);
+	if(fin.fail())
 	{
-		if(t.gt == ALLELE1) specific_full_trsts[1].push_back(t);
-		else if(t.gt == NONSPECIFIC || t.gt == UNPHASED) specific_full_trsts[0].push_back(t);
+		printf("open file %s error\n", file.c_str());
+		return 0;
 	}
-	for(transcript t: trsts[2])
+	if(bundle_capture::read_header(fin, rc) == false) return 0;
+
+	vector<bundle_base> captured;
+	bundle_base bb;
+	while(bundle_capture::read(fin, bb)) captured.push_back(bb);
+	if(bundle_capture::read_footer(fin, qlen, qcnt) == false) printf("warning: capture file %s is truncated\n", file.c_str());
+	fin.close();
+
+	if(verbose >= 1) printf("replay %lu bundles from %s\n", captured.size(), file.c_str());
+
+	for(int r = 0; r < replay_rounds; r++)
 	{
-		if(t.gt == ALLELE2) specific_full_trsts[2].push_back(t); 			
-		else if(t.gt == NONSPECIFIC || t.gt == UNPHASED) specific_full_trsts[0].push_back(t);
+		flush_outputs();
+		if(r == replay_rounds - 1) open_outputs();
+		index = 0;
+		stream_tid = -1;
+
+		double t0 = wall_clock();
+		pool = captured;
+		process(0);
+		printf("replay round %d: %lu bundles in %.3lf seconds\n", r + 1, captured.size(), wall_clock() - t0);
 	}
 
-	for(transcript& t: specific_full_trsts[0]) t.make_non_specific();
-	filter ft0(specific_full_trsts[0]);
-	/* ft0.merge_single_exon_transcripts();
-	ft0.filter_length_coverage();
-	ft0.remove_nested_transcripts(); */
-	specific_full_trsts[0].clear();
-	specific_full_trsts[0] = ft0.trs;
+	return finish();
+}
 
-	//TODO: nf trsts
-	// if(recover_partial_tx_min_overlap_with_full_tx > 0)
-	// {
-	// 	double f = recover_partial_tx_min_overlap_with_full_tx;
-	// 	recovered_allele1 = specific_trsts::recover_full_from_partial_transcripts(trsts[0], nonfull_trsts[1], f, true);
-	// 	recovered_allele2 = specific_trsts::recover_full_from_partial_transcripts(trsts[0], nonfull_trsts[2], f, true);
-	// }
+// flush the last chromosome and close the outputs
+int assembler::finish()
+{
+	flush_outputs();
+	close_outputs();
 
-	trsts[0] = trsts_collective;
+	if(DEBUG_MODE_ON && num_written < 1) throw runtime_error("No AS transcript found!");
 
-	write();
-	
+	// RPKM is not among the written attributes; the genome-wide factor is only known here
+	if(verbose >= 1 && qlen > 0) printf("RPKM factor = %.6e (%d reads, total length %.0lf)\n", 1e9 / qlen, qcnt, qlen);
+
+	if(bundle_log_file != "") blog.write(bundle_log_file);
+
+	if(terminate == true)
+	{
+		printf("error: the output of %s is incomplete\n", rc.input_file.c_str());
+		return -1;
+	}
 	return 0;
 }
 
 int assembler::process(int n)
 {
 	if(pool.size() < n) return 0;
+
+	// a chromosome is written once the first bundle of a later one is assembled, so pooled bundles
+	// wait while an earlier chromosome is still open in bb1 or bb2; the others are assembled by chromosome
+	int32_t open_tid = INT32_MAX;
+	if(bb1.hits.size() >= 1) open_tid = min(open_tid, bb1.tid);
+	if(bb2.hits.size() >= 1) open_tid = min(open_tid, bb2.tid);
+
+	vector< pair<int32_t, int> > ready;
+	vector<bundle_base> waiting;
 	for(int i = 0; i < pool.size(); i++)
 	{
-		bundle_base &bb = pool[i];
-		bb.buildbase();
+		if(pool[i].tid <= open_tid) ready.push_back(pair<int32_t, int>(pool[i].tid, i));
+		else waiting.push_back(pool[i]);
+	}
+	sort(ready.begin(), ready.end());
+
+	for(int j = 0; j < ready.size(); j++)
+	{
+		bundle_base &bb = pool[ready[j].second];
 
 		if(verbose >= 3) printf("bundle %d has %lu reads\n", index, bb.hits.size());
 
@@ -190,9 +290,37 @@ int assembler::process(int n)
 
 		if(bb.tid < 0) continue;
 
-		char buf[1024];
-		strcpy(buf, hdr->target_name[bb.tid]);
-		bb.chrm = string(buf);
+		// all bundles of a chromosome are pooled before those of the next one
+		if(bb.tid != stream_tid) flush_outputs();
+		stream_tid = bb.tid;
+
+		if(hdr != NULL)
+		{
+			char buf[1024];
+			strcpy(buf, hdr->target_name[bb.tid]);
+			bb.chrm = string(buf);
+		}
+
+		// guard huge bundles: downsample reads and bound the time spent in decomposition
+		if(max_num_bundle_hits > 0 && bb.hits.size() > max_num_bundle_hits)
+		{
+			size_t n = bb.hits.size();
+			bb.downsample(max_num_bundle_hits);
+			if(verbose >= 1) printf("huge bundle %s:%d-%d with %lu reads, downsampled to %lu reads\n", bb.chrm.c_str(), bb.lpos, bb.rpos, n, bb.hits.size());
+		}
+		deadline = max_bundle_seconds > 0 ? wall_clock() + max_bundle_seconds : 0;
+
+		// serialized now, kept once the bundle turns out to be slow enough
+		double tb = wall_clock();
+		ostringstream cap;
+		bool captured = to_capture(bb);
+		if(captured) bundle_capture::write(cap, bb);
+
+		stage_timer bt(STAGE_BUILDBASE);
+		bb.buildbase();
+		bt.stop();
+		rstats.count(COUNT_BUNDLES, 1);
+		rstats.count(COUNT_HITS, bb.hits.size());
 
 		// transcript_set ts1(bb.chrm, 0.9);	
 		// transcript_set ts2(bb.chrm, 0.9);		
@@ -201,19 +329,16 @@ int assembler::process(int n)
 		for(int i = 0; i < 3; i++) ts_full.push_back(transcript_set(bb.chrm, 0.9));
 		for(int i = 0; i < 3; i++) ts_nonfull.push_back(transcript_set(bb.chrm, 0.9));
 
-		bundle bd(bb);
-		if(bundle_mode == 1 || bundle_mode == 3)
-		{
-			bd.build(1, true);
-			bd.print(index++);
-			assemble(bd.gr, bd.hs, bb.is_allelic, ts_full, ts_nonfull);
-		}
-		if(bundle_mode == 2 || bundle_mode == 3)
-		{
-			bd.build(2, true);
-			bd.print(index++);				
-			assemble(bd.gr, bd.hs, bb.is_allelic, ts_full, ts_nonfull);
-		}
+		int n0 = trsts_collective.size();
+
+		// pexons, jset and hyper set are prepared once and shared by both modes
+		double t0 = wall_clock();
+		bundle bd(bb, rc);
+		double tp = wall_clock() - t0;
+		bd.print(index);
+		rstats.count(COUNT_FRAGMENTS, bd.br.fragments.size());
+		if(bundle_mode == 1 || bundle_mode == 3) assemble(bd, 1, tp, ts_full, ts_nonfull);
+		if(bundle_mode == 2 || bundle_mode == 3) assemble(bd, 2, tp, ts_full, ts_nonfull);
 		
 		// get allele spec transcripts again
 		//TODO: deal with nonfull
@@ -221,10 +346,24 @@ int assembler::process(int n)
 		// int mdup = assemble_duplicates / 2 + 0;
 		int sdup = 0;
 		int mdup = 0;
+		stage_timer mt(STAGE_MERGE);
 		vector<transcript> tx0 = ts_full[0].get_transcripts(sdup, mdup); 
 		vector<transcript> tx1 = ts_full[1].get_transcripts(sdup, mdup); 
 		vector<transcript> tx2 = ts_full[2].get_transcripts(sdup, mdup); 
+
+		// a downsampled bundle is assembled at the sampled depth; report its transcripts at the full depth
+		if(bb.sampling_ratio < 1.0)
+		{
+			double f = 1.0 / bb.sampling_ratio;
+			for(int k = n0; k < trsts_collective.size(); k++) trsts_collective[k].coverage *= f;
+			for(int k = 0; k < tx0.size(); k++) tx0[k].coverage *= f;
+			for(int k = 0; k < tx1.size(); k++) tx1[k].coverage *= f;
+			for(int k = 0; k < tx2.size(); k++) tx2[k].coverage *= f;
+		}
 		specific_trsts::get_allele_spec_trsts(tx1, tx2, min_allele_transcript_cov);
+		mt.stop();
+
+		if(captured && wall_clock() - tb >= capture_min_seconds) capture << cap.str();
 
 
 		// retrieve and filter transcripts
@@ -268,17 +407,54 @@ int assembler::process(int n)
 				trsts[i].insert(trsts[i].end(), gv1->begin(), gv1->end());
 				// nonfull_trsts[i].insert(nonfull_trsts[i].end(), gv2.begin(), gv2.end());
 			}
-		}		
+		}
 	}
-	pool.clear();
+	pool.swap(waiting);
+	return 0;
+}
+
+// build the splice graph of bd in the given mode and assemble it; tp is the time spent preparing bd
+int assembler::assemble(bundle &bd, int mode, double tp, vector<transcript_set> &ts_full, vector<transcript_set> &ts_nonfull)
+{
+	double t0 = wall_clock();
+	bd.build(mode, true);
+	double t1 = wall_clock();
+	index++;
+	int subs = assemble(bd.gr, bd.hs, bd.bb.is_allelic, ts_full, ts_nonfull);
+	double t2 = wall_clock();
+
+	if(bundle_log_file == "") return 0;
+
+	bundle_record r;
+	r.chrm = bd.bb.chrm;
+	r.lpos = bd.bb.lpos;
+	r.rpos = bd.bb.rpos;
+	r.strand = bd.bb.strand;
+	r.mode = mode;
+	r.index = index;
+	r.hits = bd.bb.hits.size();
+	r.fragments = bd.br.fragments.size();
+	r.regions = bd.br.regions.size();
+	r.vertices0 = bd.num_vertices0;
+	r.edges0 = bd.num_edges0;
+	r.vertices1 = bd.gr.num_vertices();
+	r.edges1 = bd.gr.num_edges();
+	r.hyper_edges = bd.hs.nodes.size();
+	r.subs = subs;
+	r.t_prepare = tp;
+	r.t_build = t1 - t0;
+	r.t_assemble = t2 - t1;
+	blog.add(r, bd.gr);
 	return 0;
 }
 
+// returns the number of subgraphs decomposed by super_graph
 int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_allelic, vector<transcript_set> &ts_full, vector<transcript_set> &ts_nonfull)
 {
 	string chrm = gr0.chrm;
 	super_graph sg(gr0, hs0);
 	sg.build();
+	rstats.count(COUNT_GRAPHS, sg.subs.size());
 
 	for(int k = 0; k < sg.subs.size(); k++)
 	{
@@ -290,6 +466,14 @@ int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_a
 		if(gr_alias.num_edges() <= 0) continue;
 
 		if(debug_bundle_only) continue; //debug parameter to build bundle only and skip assembly, default: false
+
+		bool greedy = false;
+		if(max_num_paths > 0)
+		{
+			long np = gr_alias.compute_num_paths();
+			greedy = (np > max_num_paths);
+			if(greedy && verbose >= 1) printf("huge graph gene.%d.%d with %ld s-t paths, use greedy decomposition\n", index, k, np);
+		}
 		
 		for(int r = 0; r < assemble_duplicates; r++)
 		{
@@ -311,6 +495,9 @@ int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_a
 			splice_graph gr_copy(gr);
 			hyper_set hs_copy(hs);
 			scallop sc0(gr_copy, hs_copy, false, false);
+			sc0.set_seed(task_seed(random_seed, index, k, r, 0));
+			sc0.greedy_only = greedy;
+			sc0.deadline = deadline;
 			sc0.assemble(false);
 			for(const transcript& _t: sc0.trsts)
 			{
@@ -321,6 +508,9 @@ int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_a
 
 			// partial decomp of non-AS nodes
 			scallop sc(gr, hs, r == 0 ? false : true, true);
+			sc.set_seed(task_seed(random_seed, index, k, r, 1));
+			sc.greedy_only = greedy;
+			sc.deadline = deadline;
 			sc.assemble(is_allelic);
 		
 			if(verbose >= 2)
@@ -362,14 +552,14 @@ int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_a
 				transcript t0(_t);
 				t0.make_non_specific();
 				trsts_collective.push_back(t0);
-				fl_add_0.add(t0, 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
+				fl_add_0.add(std::move(t0), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 				fl_add_1.add(transcript(_t), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 			}
 			for(const transcript& _t: non_full_trsts1)
 			{
 				transcript t0(_t);
 				t0.make_non_specific();
-				nf_add_0.add(t0, 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
+				nf_add_0.add(std::move(t0), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 				nf_add_1.add(transcript(_t), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 			}
 			for(const transcript& _t: trsts2)
@@ -377,26 +567,35 @@ int assembler::assemble(const splice_graph &gr0, const hyper_set &hs0, bool is_a
 				transcript t0(_t);
 				t0.make_non_specific();
 				trsts_collective.push_back(t0);
-				fl_add_0.add(t0, 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
+				fl_add_0.add(std::move(t0), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 				fl_add_2.add(transcript(_t), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 			}
 			for(const transcript& _t: non_full_trsts2)
 			{
 				transcript t0(_t);
 				t0.make_non_specific();
-				nf_add_0.add(t0, 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
+				nf_add_0.add(std::move(t0), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 				nf_add_2.add(transcript(_t), 1, 0, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD, TRANSCRIPT_COUNT_ONE_COVERAGE_ADD);
 			}
 
-			ts_full[0].add(fl_add_0, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
-			ts_full[1].add(fl_add_1, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
-			ts_full[2].add(fl_add_2, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
-			ts_nonfull[0].add(nf_add_0, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
-			ts_nonfull[1].add(nf_add_1, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
-			ts_nonfull[2].add(nf_add_2, TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			stage_timer mt(STAGE_MERGE);
+			ts_full[0].add(std::move(fl_add_0), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			ts_full[1].add(std::move(fl_add_1), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			ts_full[2].add(std::move(fl_add_2), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			ts_nonfull[0].add(std::move(nf_add_0), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			ts_nonfull[1].add(std::move(nf_add_1), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+			ts_nonfull[2].add(std::move(nf_add_2), TRANSCRIPT_COUNT_ADD_COVERAGE_MIN, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
 		}
 	}
-	return 0;
+	return sg.subs.size();
+}
+
+bool assembler::to_capture(const bundle_base &bb) const
+{
+	if(capture.is_open() == false) return false;
+	if(capture_chrm == "") return true;
+	if(bb.chrm != capture_chrm) return false;
+	return bb.lpos < capture_rpos && bb.rpos > capture_lpos;
 }
 
 bool assembler::determine_regional_graph(splice_graph &gr)
@@ -410,101 +609,143 @@ bool assembler::determine_regional_graph(splice_graph &gr)
 	return all_regional;
 }
 
-int assembler::assign_RPKM()
+int assembler::open_outputs()
+{
+	close_outputs();
+	if(output_bgzf && num_threads >= 2) out_pool = hts_tpool_init(num_threads);
+	for(int a = 0; a < 3; a++) outputs.push_back(new allele_output(a, rc, out_pool));
+	return 0;
+}
+
+int assembler::close_outputs()
+{
+	for(int a = 0; a < outputs.size(); a++) if(outputs[a]->close() != 0) terminate = true;
+	for(int a = 0; a < outputs.size(); a++) delete outputs[a];
+	outputs.clear();
+	if(out_pool != NULL) hts_tpool_destroy(out_pool);
+	out_pool = NULL;
+	return 0;
+}
+
+// allele-specific sets and output of the transcripts collected since the last flush, i.e., of one chromosome
+int assembler::flush_outputs()
 {
-	double factor = 1e9 / qlen;
-	for(int i = 0; i < trsts.size(); i++)
+	stage_timer wt(STAGE_WRITE);
+
+	// filter each allele
+	/* for(int i = 0; i < 3; i++)
 	{
-		vector<transcript>& trsts_of_allele = trsts[i];
-		for(int j = 0; j < trsts_of_allele.size(); j++)
-		{
-			trsts_of_allele[i].assign_RPKM(factor);
-		}
+		if (! use_filter) break;
+
+		filter ft(trsts[i]);
+		ft.merge_single_exon_transcripts();
+		trsts[i] = ft.trs;
+
+		filter ft1(nonfull_trsts[i]);
+		ft1.merge_single_exon_transcripts();
+		nonfull_trsts[i] = ft1.trs;
+	}	 */
+
+	// get specific trsts
+	for(int i = 0; i < 3; i++) specific_full_trsts[i].clear();
+
+	for(transcript t: trsts[1])
+	{
+		if(t.gt == ALLELE1) specific_full_trsts[1].push_back(t);
+		else if(t.gt == NONSPECIFIC || t.gt == UNPHASED) specific_full_trsts[0].push_back(t);
 	}
+	for(transcript t: trsts[2])
+	{
+		if(t.gt == ALLELE2) specific_full_trsts[2].push_back(t); 			
+		else if(t.gt == NONSPECIFIC || t.gt == UNPHASED) specific_full_trsts[0].push_back(t);
+	}
+
+	for(transcript& t: specific_full_trsts[0]) t.make_non_specific();
+	filter ft0(specific_full_trsts[0]);
+	/* ft0.merge_single_exon_transcripts();
+	ft0.filter_length_coverage();
+	ft0.remove_nested_transcripts(); */
+	specific_full_trsts[0].clear();
+	specific_full_trsts[0] = ft0.trs;
+
+	//TODO: nf trsts
+	// if(recover_partial_tx_min_overlap_with_full_tx > 0)
+	// {
+	// 	double f = recover_partial_tx_min_overlap_with_full_tx;
+	// 	recovered_allele1 = specific_trsts::recover_full_from_partial_transcripts(trsts[0], nonfull_trsts[1], f, true, rc.vcf);
+	// 	recovered_allele2 = specific_trsts::recover_full_from_partial_transcripts(trsts[0], nonfull_trsts[2], f, true, rc.vcf);
+	// }
+
+	trsts[0] = trsts_collective;
+
+	num_written += trsts[0].size() + trsts[1].size() + trsts[2].size();
+	rstats.count(COUNT_TRANSCRIPTS, trsts[0].size());
+
+	// the file sets of the alleles are disjoint; write allele1 and allele2 in their own threads
+	if(outputs.size() == 3 && num_threads >= 2)
+	{
+		stage_thread t1(&assembler::write_allele, this, 1);
+		stage_thread t2(&assembler::write_allele, this, 2);
+		write_allele(0);
+		t1.join();
+		t2.join();
+	}
+	else if(outputs.size() == 3)
+	{
+		for(int a = 0; a < 3; a++) write_allele(a);
+	}
+
+	for(int a = 0; a < 3 && to_collect; a++) collected[a].insert(collected[a].end(), trsts[a].begin(), trsts[a].end());
+	for(int a = 0; a < outputs.size(); a++) if(outputs[a]->fail()) terminate = true;
+
+	for(int i = 0; i < 3; i++) trsts[i].clear();
+	for(int i = 0; i < 3; i++) nonfull_trsts[i].clear();
+	for(int i = 0; i < 3; i++) specific_full_trsts[i].clear();
+	trsts_collective.clear();
+	recovered_allele1.clear();
+	recovered_allele2.clear();
 	return 0;
 }
 
-int assembler::write()
+// a = {0, 1, 2}, corresponds to merged, ALLELE1, ALLELE2
+int assembler::write_allele(int a)
 {
+	string fa;
+	if(rc.fasta_file != "") format_fasta(a, fa);
+	const vector<transcript>& v = (a == 1)? recovered_allele1 : recovered_allele2;
+	outputs[a]->write(trsts[a], specific_full_trsts[a], nonfull_trsts[a], v, fa);
+	return 0;
+}
 
-	if(verbose >= 1) printf("\nWriting outputs for all transcripts.\n");
-
-	for(int a = 0; a < trsts.size(); a++)
+// fasta of the transcripts of allele a, spliced from one reference window per run of overlapping transcripts
+int assembler::format_fasta(int a, string &fa)
+{
+	const vector<transcript> &v = trsts[a];
+	ref_window w;
+	for(int i = 0; i < v.size(); )
 	{
-		assert(a >= 0 && a <= 3);
-		string allele_name_fix;
-		if (a == 0) allele_name_fix = "merged";
-		if (a == 1) allele_name_fix = "allele1";
-		if (a == 2) allele_name_fix = "allele2";
-		string outname_prefix = output_file + "." + allele_name_fix;
-
-		if(verbose >= 2) 
-		{
-			if (a == 0) printf("\tWriting outputs for all transcripts of merged/non-specific alleles.\n");
-			if (a == 1) printf("\tWriting outputs for all transcripts of allele 1.\n");
-			if (a == 2) printf("\tWriting outputs for all transcripts of allele 2.\n");
-			assert(a <= 2);
-		}
-		
-		// write gtf
-		if (output_file != "")
+		if(v[i].exons.size() == 0)
 		{
-			ofstream fout((outname_prefix + ".gtf").c_str());
-			if(!fout.fail()) for(const transcript &t : trsts[a]) t.write(fout);
-			fout.close();
-		}
-		
-		// write gvf w/ variants
-		if (output_file != "")
-		{
-			ofstream gvfout((outname_prefix + ".gvf").c_str());
-			if(!gvfout.fail()) 
-			{
-				gvfout << "#allele \"ALLELE1/2\" correspondes to the first/second allele of \"GT\" field in the vcf file input." << endl;
-				for(const transcript &t : trsts[a]) t.write_gvf(gvfout);
-			}
-			gvfout.close();
-		}
-		
-		// write fasta w/ variants
-		if(fasta_input != "") 
-		{
-			ofstream faout((outname_prefix + ".fa").c_str());	
-			// if(!faout.fail()) for(const transcript &t : trsts_of_allele) t.write_fasta(faout, 60, fai);
-			cerr << "fasta output is not implemented yet." << endl; //TODO:
-			faout.close();
-		}			
-
-		// write specific transcritps' gtf and gvf
-		if (output_file != "")
-		{
-			if (a == 0) outname_prefix = output_file + "." + "nonspec.multi-exon";
-			if (a == 1) outname_prefix = output_file + "." + "allele1spec.multi-exon";
-			if (a == 2) outname_prefix = output_file + "." + "allele2spec.multi-exon";
-			ofstream gvfout((outname_prefix + ".gvf").c_str());
-			if(!gvfout.fail())	for(const transcript &t : specific_full_trsts[a]) t.write_gvf(gvfout);
-			gvfout.close();
-			ofstream gtfout((outname_prefix + ".gtf").c_str());
-			if(!gtfout.fail())	for(const transcript &t : specific_full_trsts[a]) t.write(gtfout);
-			gtfout.close();
+			i++;
+			continue;
 		}
 
-		// write non-full-length gvf w/ variants
-		if(output_file1 != "")
+		PI32 p = v[i].get_bounds();
+		int32_t l = p.first.p32;
+		int32_t r = p.second.p32;
+		int j = i + 1;
+		for(; j < v.size() && v[j].seqname == v[i].seqname; j++)
 		{
-			ofstream fout1((output_file1 + "." + allele_name_fix + ".gvf").c_str());
-			if(!fout1.fail()) for(const transcript &t : nonfull_trsts[a]) t.write_gvf(fout1);
-			fout1.close();
+			if(v[j].exons.size() == 0) continue;
+			PI32 q = v[j].get_bounds();
+			if(q.first.p32 >= r || q.second.p32 <= l) break;
+			l = min(l, q.first.p32);
+			r = max(r, q.second.p32);
 		}
 
-		// write recovered partial transcripts
-		if(recover_partial_tx_min_overlap_with_full_tx > 0 && a != 0)
-		{
-			ofstream frecov((output_file1 + ".re." + allele_name_fix + ".gvf").c_str());
-			const vector<transcript>& v = (a == 1)? recovered_allele1 : recovered_allele2;
-			if(!frecov.fail()) for(const transcript &t : v) t.write_gvf(frecov);
-			frecov.close();
-		}
+		if(wc.fetch_reference(w, v[i].seqname, l, r) < 0) return 0;
+		for(int k = i; k < j; k++) v[k].format_fasta(fa, fasta_line_length, w.seq, w.lpos);
+		i = j;
 	}
 	return 0;
-}
\ No newline at end of file
+}
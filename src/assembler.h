@@ -18,16 +18,23 @@ See LICENSE for licensing.
 #include "hyper_set.h"
 #include "transcript_set.h"
 #include "phaser.h"
+#include "bundle_log.h"
+#include "out_writer.h"
+#include "run_context.h"
 
 using namespace std;
 
+class bundle;
+
 class assembler
 {
 public:
-	assembler();
+	assembler(const run_config &rc);
 	~assembler();
 
 private:
+	run_config rc;			// restored from the header by replay
+	worker_context wc;		// reads and assembles the bundles
 	samFile *sfn;
 	bam_hdr_t *hdr;
 	bam1_t *b1t;
@@ -37,7 +44,10 @@ private:
 
 	int hid;
 	int index;
-	bool terminate;
+	int32_t stream_tid;		// chromosome of the transcripts not yet written
+	int num_written;
+	double deadline;		// wall-clock budget of the current bundle, 0: no limit
+	bool terminate;			// an output could not be written, stop reading
 	int qcnt;
 	double qlen;
 	vector< vector<transcript> > trsts;				  // 0: merged; 1: ALLELE1; 2: ALLELE2
@@ -48,14 +58,36 @@ private:
 
 	vector<transcript> trsts_collective;				  // high recall, low precision; 0: merged; 1: ALLELE1; 2: ALLELE2
 
+	vector<allele_output*> outputs;	// 0: merged; 1: ALLELE1; 2: ALLELE2, open while chromosomes are written
+	bool to_collect;				// keep the flushed transcripts in collected, for assemble_reads
+	vector< vector<transcript> > collected;
+	hts_tpool *out_pool;
+
+	bundle_log blog;		// per-bundle graph sizes and stage times, if bundle_log_file is given
+
+	ofstream capture;		// captured bundles, if capture_file is given
+	string capture_chrm;	// capture_region, empty: all
+	int32_t capture_lpos;
+	int32_t capture_rpos;
+
 public:
 	int assemble();
+	int replay(const string &file);
+	int add_read(bam1_t *b, const string &chrm);
+	int assemble_reads(vector< vector<transcript> > &v);
 
 private:
+	int read_hit(bam1_t *b, const string &chrm);
 	int process(int n);
+	int finish();			// -1 if an output could not be written
+	bool to_capture(const bundle_base &bb) const;
+	int assemble(bundle &bd, int mode, double tp, vector<transcript_set> &ts1, vector<transcript_set> &ts2);
 	int assemble(const splice_graph &gr, const hyper_set &hs, bool is_allelic, vector<transcript_set> &ts1, vector<transcript_set> &ts2);
-	int assign_RPKM();
-	int write();
+	int open_outputs();
+	int flush_outputs();
+	int close_outputs();
+	int write_allele(int a);
+	int format_fasta(int a, string &fa);
 	bool determine_regional_graph(splice_graph &gr);
 };
 
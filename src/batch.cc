@@ -0,0 +1,133 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "batch.h"
+#include "config.h"
+#include "previewer.h"
+#include "assembler.h"
+
+batch::batch(const string &manifest)
+	: next(0)
+{
+	read_manifest(manifest);
+}
+
+int batch::read_manifest(const string &file)
+{
+	ifstream fin(file.c_str());
+	if(fin.fail())
+	{
+		printf("open file %s error\n", file.c_str());
+		exit(0);
+	}
+
+	string line;
+	while(getline(fin, line))
+	{
+		if(line == "" || line[0] == '#') continue;
+
+		string bam, prefix, extra;
+		istringstream sstr(line);
+		sstr >> bam >> prefix >> extra;
+		if(bam == "") continue;
+		if(prefix == "" || extra != "")
+		{
+			printf("error: manifest line \"%s\" is not <bam-file> <output-prefix>\n", line.c_str());
+			exit(0);
+		}
+
+		run_config rc;
+		rc.input_file = bam;
+		rc.output_file = prefix;
+		samples.push_back(rc);
+	}
+	fin.close();
+
+	if(samples.size() == 0)
+	{
+		printf("error: no samples in manifest %s\n", file.c_str());
+		exit(0);
+	}
+	failed.assign(samples.size(), 0);
+	return 0;
+}
+
+int batch::run()
+{
+	if(verbose >= 1) printf("batch of %lu samples\n", samples.size());
+
+	process(num_threads, false);
+
+	int nf = 0;
+	for(int k = 0; k < samples.size(); k++)
+	{
+		if(failed[k] == 0) continue;
+		printf("error: sample %s cannot be previewed\n", samples[k].input_file.c_str());
+		nf++;
+	}
+	if(nf >= 1)
+	{
+		printf("error: %d of %lu samples failed, none is assembled\n", nf, samples.size());
+		return -1;
+	}
+
+	for(int k = 0; k < samples.size() && verbose >= 1; k++)
+	{
+		const run_config &rc = samples[k];
+		printf("sample %s: library_type = %d, isize = %.2lf +/- %.2lf, median = %d, low = %d, high = %d\n", rc.input_file.c_str(),
+				rc.library_type, rc.insertsize_ave, rc.insertsize_std, rc.insertsize_median, rc.insertsize_low, rc.insertsize_high);
+	}
+
+	if(preview_only == true) return 0;
+
+	process(batch_jobs, true);
+
+	nf = 0;
+	for(int k = 0; k < samples.size(); k++)
+	{
+		if(failed[k] == 0) continue;
+		printf("error: the output of sample %s into %s is incomplete\n", samples[k].input_file.c_str(), samples[k].output_file.c_str());
+		nf++;
+	}
+	return nf >= 1 ? -1 : 0;
+}
+
+int batch::process(int n, bool to_assemble)
+{
+	next = 0;
+	if(n > samples.size()) n = samples.size();
+
+	vector<thread> threads;
+	for(int i = 1; i < n; i++) threads.push_back(thread(&batch::worker, this, to_assemble));
+	worker(to_assemble);
+	for(int i = 0; i < threads.size(); i++) threads[i].join();
+	return 0;
+}
+
+// samples are only written by the previewer of their own; the assemblers take copies
+int batch::worker(bool to_assemble)
+{
+	for(int k = next++; k < samples.size(); k = next++)
+	{
+		if(to_assemble == false)
+		{
+			previewer pv(samples[k]);
+			if(pv.preview() != 0) failed[k] = 1;
+			continue;
+		}
+
+		if(verbose >= 1) printf("assemble sample %s into %s\n", samples[k].input_file.c_str(), samples[k].output_file.c_str());
+		assembler asmb(samples[k]);
+		if(asmb.assemble() != 0) failed[k] = 1;
+	}
+	return 0;
+}
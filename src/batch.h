@@ -0,0 +1,42 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include "run_context.h"
+
+using namespace std;
+
+/*
+**	batch assembles the samples of a manifest, one line of <bam-file> <output-prefix> per sample,
+**	in one process: the vcf is parsed once and shared; the samples are previewed concurrently
+**	(num_threads), then assembled batch_jobs at a time, each by its own assembler
+*/
+class batch
+{
+public:
+	batch(const string &manifest);
+
+private:
+	vector<run_config> samples;
+	vector<int> failed;			// per sample, set by its previewer or assembler; int, not bool, as workers write them concurrently
+	atomic<int> next;			// next sample to be taken by a worker
+
+public:
+	int run();				// -1 if a sample fails to be previewed (before any is assembled) or written
+
+private:
+	int read_manifest(const string &file);
+	int process(int n, bool to_assemble);		// with n workers
+	int worker(bool to_assemble);
+};
+
+#endif
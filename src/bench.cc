@@ -0,0 +1,634 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+/*
+**	altai_bench: micro-benchmarks of the hot functions, graph-level benchmarks of scallop and phaser,
+**	and end-to-end runs of altai; results are written as JSON with a fixed layout, see print_bench_help()
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "htslib/sam.h"
+#include "config.h"
+#include "hit.h"
+#include "bundle_base.h"
+#include "transcript_set.h"
+#include "subsetsum.h"
+#include "hyper_set.h"
+#include "splice_graph.h"
+#include "scallop.h"
+#include "phaser.h"
+#include "util.h"
+
+using namespace std;
+
+// options
+static string altai_bin = "";			// altai binary for end-to-end runs, skipped if empty
+static string data_dir = "";			// directory with altai-eg.bam and altai-eg.vcf, end-to-end runs skipped if empty
+static string simreads_bin = "";		// altai_simreads binary for the simulated end-to-end run, skipped if empty
+static double sim_depth = 20;
+static string work_dir = "bench.out";
+static string json_file = "bench.json";
+static int num_repeats = 5;
+static int bam_scale = 10;
+static unsigned int seed = 42;		// srand before each synthetic input; scallop has its own rng, seeded by set_seed
+
+// one benchmark result
+class bench_result
+{
+public:
+	string group;
+	string name;
+	vector<pair<string, string> > params;	// name, JSON value
+	long items;
+	vector<double> seconds;					// one per repeat
+};
+
+static vector<bench_result> results;
+
+static int add_result(const string &group, const string &name, const vector<pair<string, string> > &params, long items, const vector<double> &seconds)
+{
+	bench_result r;
+	r.group = group;
+	r.name = name;
+	r.params = params;
+	r.items = items;
+	r.seconds = seconds;
+	results.push_back(r);
+
+	vector<double> s = seconds;
+	sort(s.begin(), s.end());
+	printf("%-8s %-28s", group.c_str(), name.c_str());
+	for(int i = 0; i < params.size(); i++) printf(" %s=%s", params[i].first.c_str(), params[i].second.c_str());
+	printf("  items = %ld, median = %.6lf s\n", items, s[s.size() / 2]);
+	fflush(stdout);
+	return 0;
+}
+
+static vector<pair<string, string> > make_params(const string &k1, long v1, const string &k2 = "", long v2 = 0)
+{
+	vector<pair<string, string> > v;
+	v.push_back(pair<string, string>(k1, tostring(v1)));
+	if(k2 != "") v.push_back(pair<string, string>(k2, tostring(v2)));
+	return v;
+}
+
+static int write_json(const string &file)
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if(f == NULL)
+	{
+		fprintf(stderr, "cannot open %s to write benchmark results\n", file.c_str());
+		return -1;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"version\": \"%s\",\n", version.c_str());
+	fprintf(f, "  \"seed\": %u,\n", seed);
+	fprintf(f, "  \"repeats\": %d,\n", num_repeats);
+	fprintf(f, "  \"results\": [\n");
+	for(int i = 0; i < results.size(); i++)
+	{
+		const bench_result &r = results[i];
+		vector<double> s = r.seconds;
+		sort(s.begin(), s.end());
+		double med = s[s.size() / 2];
+
+		fprintf(f, "    {\"group\": \"%s\", \"name\": \"%s\", \"params\": {", r.group.c_str(), r.name.c_str());
+		for(int k = 0; k < r.params.size(); k++)
+		{
+			fprintf(f, "%s\"%s\": %s", k == 0 ? "" : ", ", r.params[k].first.c_str(), r.params[k].second.c_str());
+		}
+		fprintf(f, "}, \"items\": %ld, \"repeats\": %lu, \"median_seconds\": %.6lf, \"min_seconds\": %.6lf, \"max_seconds\": %.6lf, \"items_per_second\": %.1lf}%s\n",
+				r.items, s.size(), med, s.front(), s.back(), med > 0 ? r.items / med : 0, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n");
+	fprintf(f, "}\n");
+	fclose(f);
+	return 0;
+}
+
+/*
+** synthetic reads: 100bp, every third one spliced (50M400N50M), one read every 'step' bp on chromosome "bench";
+** bases are all A (even reads) or all C (odd reads), matching the two alleles of the synthetic SNPs
+*/
+static int make_read(bam1_t *b, int32_t pos, bool spliced, bool alt, const string &qname)
+{
+	vector<uint32_t> cigar;
+	if(spliced)
+	{
+		cigar.push_back(50 << BAM_CIGAR_SHIFT | BAM_CMATCH);
+		cigar.push_back(400 << BAM_CIGAR_SHIFT | BAM_CREF_SKIP);
+		cigar.push_back(50 << BAM_CIGAR_SHIFT | BAM_CMATCH);
+	}
+	else
+	{
+		cigar.push_back(100 << BAM_CIGAR_SHIFT | BAM_CMATCH);
+	}
+	int qlen = 100;
+
+	int nul = 4 - qname.size() % 4;			// keep the cigar 4-byte aligned
+	int l_qname = qname.size() + nul;
+	int l_data = l_qname + 4 * cigar.size() + (qlen + 1) / 2 + qlen;
+	if(b->m_data < l_data)
+	{
+		b->m_data = l_data;
+		b->data = (uint8_t*)realloc(b->data, l_data);
+	}
+	b->l_data = l_data;
+
+	uint8_t *p = b->data;
+	memcpy(p, qname.c_str(), qname.size());
+	memset(p + qname.size(), 0, nul);
+	p += l_qname;
+	memcpy(p, cigar.data(), 4 * cigar.size());
+	p += 4 * cigar.size();
+	uint8_t nt = alt ? 2 : 1;				// nt16 code of C or A
+	memset(p, nt << 4 | nt, (qlen + 1) / 2);
+	p += (qlen + 1) / 2;
+	memset(p, 30, qlen);
+
+	b->core.tid = 0;
+	b->core.pos = pos;
+	b->core.qual = 60;
+	b->core.l_qname = l_qname;
+	b->core.l_extranul = nul - 1;
+	b->core.flag = 0;
+	b->core.n_cigar = cigar.size();
+	b->core.l_qseq = qlen;
+	b->core.mtid = -1;
+	b->core.mpos = -1;
+	b->core.isize = 0;
+	b->core.bin = bam_reg2bin(pos, pos + bam_cigar2rlen(cigar.size(), cigar.data()));
+	return 0;
+}
+
+static int make_reads(vector<bam1_t*> &reads, int n, int step)
+{
+	for(int i = 0; i < n; i++)
+	{
+		bam1_t *b = bam_init1();
+		make_read(b, 1000 + i * step, i % 3 == 0, i % 2 == 1, "read." + tostring(i));
+		reads.push_back(b);
+	}
+	return 0;
+}
+
+static int free_reads(vector<bam1_t*> &reads)
+{
+	for(int i = 0; i < reads.size(); i++) bam_destroy1(reads[i]);
+	reads.clear();
+	return 0;
+}
+
+// phased SNPs A|C on chromosome "bench", snp_per_kb per 1000bp over [0, len)
+static vcf_data bench_vcf;
+static int make_variants(int snp_per_kb, int32_t len)
+{
+	bench_vcf.vcf_pos_map.clear();
+	bench_vcf.vcf_ale_len.clear();
+	if(snp_per_kb <= 0) return 0;
+
+	int step = 1000 / snp_per_kb;
+	for(int32_t p = step / 2; p < len; p += step)
+	{
+		map<string, genotype> ng;
+		ng.insert(pair<string, genotype>("A", ALLELE1));
+		ng.insert(pair<string, genotype>("C", ALLELE2));
+		bench_vcf.vcf_pos_map["bench"][p] = ng;
+		bench_vcf.vcf_ale_len["bench"][p] = 1;
+	}
+	return 0;
+}
+
+static int bench_build_features()
+{
+	int n = 20000;
+	int snps[] = {0, 1, 10, 50};
+	for(int d = 0; d < 4; d++)
+	{
+		vector<bam1_t*> reads;
+		make_reads(reads, n, 50);
+		make_variants(snps[d], 1000 + n * 50 + 1000);
+
+		run_config rc;
+		rc.vcf = &bench_vcf;
+		worker_context wc(rc);
+		vector<hit> hits;
+		for(int i = 0; i < n; i++) hits.push_back(hit(reads[i], "bench", i, wc));
+
+		vector<double> secs;
+		for(int r = 0; r < num_repeats; r++)
+		{
+			wc.vc = variant_cursor();
+			double t = wall_clock();
+			for(int i = 0; i < n; i++) hits[i].build_features(reads[i], wc);
+			secs.push_back(wall_clock() - t);
+		}
+		add_result("micro", "hit_build_features", make_params("snp_per_kb", snps[d]), n, secs);
+		free_reads(reads);
+	}
+	make_variants(0, 0);
+	return 0;
+}
+
+static int bench_buildbase()
+{
+	int n = 20000;
+	vector<bam1_t*> reads;
+	make_reads(reads, n, 5);
+	make_variants(10, 1000 + n * 5 + 1000);
+
+	run_config rc;
+	rc.vcf = &bench_vcf;
+	worker_context wc(rc);
+	bundle_base bb0;
+	for(int i = 0; i < n; i++)
+	{
+		hit ht(reads[i], "bench", i, wc);
+		ht.set_tags(reads[i]);
+		ht.set_strand(rc.library_type);
+		bb0.add_hit(ht);
+	}
+	bb0.chrm = "bench";
+
+	vector<double> secs;
+	for(int r = 0; r < num_repeats; r++)
+	{
+		bundle_base bb = bb0;
+		double t = wall_clock();
+		bb.buildbase();
+		secs.push_back(wall_clock() - t);
+	}
+	add_result("micro", "bundle_base_buildbase", make_params("snp_per_kb", 10), n, secs);
+
+	free_reads(reads);
+	make_variants(0, 0);
+	return 0;
+}
+
+static int bench_transcript_set()
+{
+	int k = 2000;
+	int n = 50000;
+	srand(seed);
+
+	// a pool of distinct transcripts, drawn n times
+	vector<transcript> pool;
+	for(int i = 0; i < k; i++)
+	{
+		transcript t;
+		t.seqname = "bench";
+		t.strand = '+';
+		t.gt = UNPHASED;
+		t.coverage = 1 + rand() % 100;
+		int32_t p = (i / 10) * 10000 + rand() % 200;
+		int m = 2 + rand() % 5;
+		for(int j = 0; j < m; j++)
+		{
+			int32_t q = p + 100 + rand() % 200;
+			t.add_exon(as_pos32(p, "$"), as_pos32(q, "$"));
+			p = q + 200 + rand() % 800;
+		}
+		pool.push_back(t);
+	}
+
+	vector<int> draws;
+	for(int i = 0; i < n; i++) draws.push_back(rand() % k);
+
+	vector<double> secs;
+	for(int r = 0; r < num_repeats; r++)
+	{
+		transcript_set ts("bench", 0.9);
+		double t = wall_clock();
+		for(int i = 0; i < n; i++) ts.add(pool[draws[i]], 1, 0, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD, TRANSCRIPT_COUNT_ADD_COVERAGE_ADD);
+		secs.push_back(wall_clock() - t);
+	}
+	add_result("micro", "transcript_set_add", make_params("distinct", k), n, secs);
+	return 0;
+}
+
+static int bench_subsetsum()
+{
+	int n = 2000;
+	int sizes[] = {4, 8, 12};
+	for(int d = 0; d < 3; d++)
+	{
+		srand(seed);
+		vector< vector<PI> > ss, tt;
+		for(int i = 0; i < n; i++)
+		{
+			vector<PI> s, t;
+			for(int j = 0; j < sizes[d]; j++) s.push_back(PI(1 + rand() % 1000, j));
+			for(int j = 0; j < sizes[d] / 2; j++) t.push_back(PI(1 + rand() % 1000, j));
+			ss.push_back(s);
+			tt.push_back(t);
+		}
+
+		vector<double> secs;
+		for(int r = 0; r < num_repeats; r++)
+		{
+			double t = wall_clock();
+			for(int i = 0; i < n; i++)
+			{
+				subsetsum sss(ss[i], tt[i]);
+				sss.solve();
+			}
+			secs.push_back(wall_clock() - t);
+		}
+		add_result("micro", "subsetsum_solve", make_params("sources", sizes[d], "targets", sizes[d] / 2), n, secs);
+	}
+	return 0;
+}
+
+static int bench_hyper_set()
+{
+	int ne = 2000;
+	int np = 5000;
+	int nq = 20000;
+	srand(seed);
+
+	// phasing paths over consecutive edges, as produced for a linear chain of exons
+	hyper_set hs;
+	for(int i = 0; i < np; i++)
+	{
+		int s = rand() % (ne - 8);
+		int m = 2 + rand() % 6;
+		vector<int> v;
+		for(int j = 0; j < m; j++) v.push_back(s + j);
+		hs.edges.push_back(v);
+		hs.ecnts.push_back(1 + rand() % 10);
+	}
+	hs.build_index();
+
+	vector< vector<int> > queries;
+	for(int i = 0; i < nq; i++)
+	{
+		int s = rand() % (ne - 3);
+		int m = 2 + rand() % 2;
+		vector<int> v;
+		for(int j = 0; j < m; j++) v.push_back(s + j);
+		queries.push_back(v);
+	}
+
+	vector<double> secs;
+	long sum = 0;
+	for(int r = 0; r < num_repeats; r++)
+	{
+		double t = wall_clock();
+		for(int i = 0; i < nq; i++) sum += hs.get_intersection(queries[i]).size();
+		secs.push_back(wall_clock() - t);
+	}
+	if(sum < 0) printf("%ld\n", sum);
+	add_result("micro", "hyper_set_get_intersection", make_params("paths", np, "edges", ne), nq, secs);
+	return 0;
+}
+
+// decompose each graph with scallop (as sc0 in assembler) and with scallop + phaser (as sc in assembler)
+static int bench_graphs(const string &name, const vector<splice_graph> &grs, const vector<pair<string, string> > &params)
+{
+	vector<double> secs1, secs2;
+	for(int r = 0; r < num_repeats; r++)
+	{
+		double t1 = 0, t2 = 0;
+		for(int i = 0; i < grs.size(); i++)
+		{
+			hyper_set hs;
+			splice_graph gr1(grs[i]);
+			double t = wall_clock();
+			scallop sc0(gr1, hs, false, false);
+			sc0.set_seed(seed);
+			sc0.assemble(false);
+			t1 += wall_clock() - t;
+
+			splice_graph gr2(grs[i]);
+			t = wall_clock();
+			scallop sc(gr2, hs, false, true);
+			sc.set_seed(seed);
+			sc.assemble(true);
+			phaser ph(sc, true);
+			t2 += wall_clock() - t;
+		}
+		secs1.push_back(t1);
+		secs2.push_back(t2);
+	}
+	add_result("graph", "scallop_" + name, params, grs.size(), secs1);
+	add_result("graph", "phaser_" + name, params, grs.size(), secs2);
+	return 0;
+}
+
+static int bench_simulated_graphs()
+{
+	int n = 20;
+	int nv[] = {20, 50, 100};
+	int ne[] = {40, 120, 300};
+	for(int d = 0; d < 3; d++)
+	{
+		srand(seed);
+		vector<splice_graph> grs(n);
+		for(int i = 0; i < n; i++)
+		{
+			grs[i].simulate(nv[d], ne[d], 100);
+			grs[i].gid = "sim." + tostring(d) + "." + tostring(i);
+		}
+		bench_graphs("simulated", grs, make_params("vertices", nv[d], "edges", ne[d]));
+	}
+	return 0;
+}
+
+// graphs dumped by altai --bundle_log_graphs, listed in the last column of the bundle log
+static int bench_loaded_graphs(const string &bundle_log)
+{
+	ifstream fin(bundle_log.c_str());
+	if(fin.fail()) return 0;
+
+	vector<splice_graph> grs;
+	string line;
+	getline(fin, line);
+	while(getline(fin, line))
+	{
+		vector<string> v = split(line, "\t");
+		if(v.size() == 0 || v.back() == ".") continue;
+		splice_graph gr;
+		gr.build(v.back());
+		if(gr.num_vertices() <= 2) continue;
+		gr.gid = "loaded." + tostring(grs.size());
+		grs.push_back(gr);
+	}
+	if(grs.size() == 0) return 0;
+
+	bench_graphs("loaded", grs, make_params("graphs", grs.size()));
+	return 0;
+}
+
+// copy in to out with every record repeated scale times, query names suffixed to keep pairs apart
+static int make_scaled_bam(const string &in, const string &out, int scale)
+{
+	samFile *fi = sam_open(in.c_str(), "r");
+	if(fi == NULL) return -1;
+	bam_hdr_t *hdr = sam_hdr_read(fi);
+	samFile *fo = sam_open(out.c_str(), "wb");
+	if(fo == NULL) return -1;
+	sam_hdr_write(fo, hdr);
+
+	bam1_t *b = bam_init1();
+	bam1_t *c = bam_init1();
+	while(sam_read1(fi, hdr, b) >= 0)
+	{
+		string qname = hit::get_qname(b);
+		int rest = b->l_data - b->core.l_qname;
+		for(int k = 0; k < scale; k++)
+		{
+			string q = qname + "." + tostring(k);
+			int nul = 4 - q.size() % 4;
+			int l_qname = q.size() + nul;
+			int l_data = l_qname + rest;
+			if(c->m_data < l_data)
+			{
+				c->m_data = l_data;
+				c->data = (uint8_t*)realloc(c->data, l_data);
+			}
+			c->core = b->core;
+			c->core.l_qname = l_qname;
+			c->core.l_extranul = nul - 1;
+			c->l_data = l_data;
+			memcpy(c->data, q.c_str(), q.size());
+			memset(c->data + q.size(), 0, nul);
+			memcpy(c->data + l_qname, b->data + b->core.l_qname, rest);
+			sam_write1(fo, hdr, c);
+		}
+	}
+	bam_destroy1(b);
+	bam_destroy1(c);
+	bam_hdr_destroy(hdr);
+	sam_close(fi);
+	sam_close(fo);
+	return 0;
+}
+
+static int run_altai(const string &bam, const string &prefix, const string &extra)
+{
+	string cmd = altai_bin + " -i " + bam + " -j " + data_dir + "/altai-eg.vcf -o " + prefix;
+	cmd += " --insertsize_median 250 --insertsize_low 50 --insertsize_high 600 " + extra + " > " + prefix + ".log 2>&1";
+	return system(cmd.c_str());
+}
+
+// reads simulated by altai_simreads from the transcripts assembled from the example, with its phased variants
+static int make_simulated_bam(const string &models, const string &out)
+{
+	char buf[1024];
+	sprintf(buf, " --depth %.2lf --seed %u --wasp", sim_depth, seed);
+	string cmd = simreads_bin + " -g " + models + " -v " + data_dir + "/altai-eg.vcf -o " + out + buf;
+	cmd += " > " + out + ".log 2>&1";
+	return system(cmd.c_str());
+}
+
+// the first run is a warm-up that also dumps the splice graphs; it is not timed
+static int bench_end_to_end(const string &name, const string &bam, const vector<pair<string, string> > &params)
+{
+	string prefix = work_dir + "/" + name;
+	string extra = "--bundle_log " + prefix + ".bundles.tsv --bundle_log_graphs --stats-json " + prefix + ".stats.json";
+	if(run_altai(bam, prefix, extra) != 0)
+	{
+		fprintf(stderr, "altai failed on %s, see %s.log\n", bam.c_str(), prefix.c_str());
+		return -1;
+	}
+
+	vector<double> secs;
+	for(int r = 0; r < num_repeats; r++)
+	{
+		double t = wall_clock();
+		run_altai(bam, prefix, "");
+		secs.push_back(wall_clock() - t);
+	}
+
+	long n = 0;
+	samFile *fi = sam_open(bam.c_str(), "r");
+	bam_hdr_t *hdr = sam_hdr_read(fi);
+	bam1_t *b = bam_init1();
+	while(sam_read1(fi, hdr, b) >= 0) n++;
+	bam_destroy1(b);
+	bam_hdr_destroy(hdr);
+	sam_close(fi);
+
+	add_result("e2e", name, params, n, secs);
+	return 0;
+}
+
+static int print_bench_help()
+{
+	printf("usage: altai_bench [options]\n");
+	printf(" %-42s  %s\n", "--altai <filename>",  "altai binary for the end-to-end runs, default: none (skipped)");
+	printf(" %-42s  %s\n", "--data <directory>",  "directory with altai-eg.bam and altai-eg.vcf, default: none (skipped)");
+	printf(" %-42s  %s\n", "--simreads <filename>",  "altai_simreads binary, to also run altai on reads simulated from the example, default: none (skipped)");
+	printf(" %-42s  %s\n", "--sim_depth <float>",  "coverage of each transcript in the simulated end-to-end input, default: 20");
+	printf(" %-42s  %s\n", "--work <directory>",  "directory for end-to-end outputs, default: bench.out");
+	printf(" %-42s  %s\n", "-o <filename>",  "file to which results will be written to as JSON, default: bench.json");
+	printf(" %-42s  %s\n", "--repeats <integer>",  "timed repeats of each benchmark, the median is reported, default: 5");
+	printf(" %-42s  %s\n", "--scale <integer>",  "copies of each read in the scaled end-to-end input, default: 10");
+	printf(" %-42s  %s\n", "--seed <integer>",  "seed for the synthetic inputs and the orderings of scallop, default: 42");
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(string(argv[i]) == "--altai" && i + 1 < argc) altai_bin = string(argv[++i]);
+		else if(string(argv[i]) == "--data" && i + 1 < argc) data_dir = string(argv[++i]);
+		else if(string(argv[i]) == "--simreads" && i + 1 < argc) simreads_bin = string(argv[++i]);
+		else if(string(argv[i]) == "--sim_depth" && i + 1 < argc) sim_depth = atof(argv[++i]);
+		else if(string(argv[i]) == "--work" && i + 1 < argc) work_dir = string(argv[++i]);
+		else if(string(argv[i]) == "-o" && i + 1 < argc) json_file = string(argv[++i]);
+		else if(string(argv[i]) == "--repeats" && i + 1 < argc) num_repeats = atoi(argv[++i]);
+		else if(string(argv[i]) == "--scale" && i + 1 < argc) bam_scale = atoi(argv[++i]);
+		else if(string(argv[i]) == "--seed" && i + 1 < argc) seed = atoi(argv[++i]);
+		else
+		{
+			print_bench_help();
+			return 1;
+		}
+	}
+	if(num_repeats < 1) num_repeats = 1;
+
+	verbose = 0;
+
+	bench_build_features();
+	bench_buildbase();
+	bench_transcript_set();
+	bench_subsetsum();
+	bench_hyper_set();
+	bench_simulated_graphs();
+
+	if(altai_bin != "" && data_dir != "")
+	{
+		string cmd = "mkdir -p " + work_dir;
+		if(system(cmd.c_str()) != 0) return 1;
+
+		string eg = data_dir + "/altai-eg.bam";
+		string scaled = work_dir + "/altai-eg.x" + tostring(bam_scale) + ".bam";
+		make_scaled_bam(eg, scaled, bam_scale);
+
+		if(bench_end_to_end("altai_eg", eg, make_params("scale", 1)) == 0) bench_loaded_graphs(work_dir + "/altai_eg.bundles.tsv");
+		bench_end_to_end("altai_eg_scaled", scaled, make_params("scale", bam_scale));
+
+		string sim = work_dir + "/altai-eg.sim.bam";
+		vector<pair<string, string> > params;
+		params.push_back(pair<string, string>("depth", tostring(sim_depth)));
+		if(simreads_bin != "" && make_simulated_bam(work_dir + "/altai_eg.merged.gtf", sim) == 0) bench_end_to_end("altai_sim", sim, params);
+		else if(simreads_bin != "") fprintf(stderr, "altai_simreads failed, see %s.log\n", sim.c_str());
+	}
+
+	write_json(json_file);
+	return 0;
+}
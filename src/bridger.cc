@@ -6,37 +6,80 @@ Part of Scallop2
 See LICENSE for licensing.
 */
 
+#include <unordered_map>
+
 #include "bridger.h"
 #include "config.h"
+#include "run_stats.h"
 
 int entry::print()
 {
 	printf("entry: length = %d, trace = (%d, %d), stack = (", length, trace1, trace2);
-	printv(stack);
+	for(int i = 0; i < dp_stack_size; i++) printf("%d, ", stack[i]);
 	printf(")\n");
 	return 0;
 }
 
+// ties are broken by the order candidates are generated, so the top-k is well defined
 bool entry_compare(const entry &x, const entry &y)
 {
-	for(int i = 0; i < x.stack.size() && i < y.stack.size(); i++)
+	for(int i = 0; i < dp_stack_size; i++)
 	{
 		if(x.stack[i] > y.stack[i]) return true;
 		if(x.stack[i] < y.stack[i]) return false;
 	}
 	if(x.length < y.length) return true;
-	else return false;
+	if(x.length > y.length) return false;
+	if(x.trace1 > y.trace1) return true;
+	if(x.trace1 < y.trace1) return false;
+	return x.trace2 < y.trace2;
 }
 
-bridger::bridger(bundle_bridge *b, const genotype &g)
+int dp_table::init(int _lo, int _hi, int _k)
+{
+	lo = _lo;
+	hi = _hi;
+	k = _k;
+	sources.clear();
+	targets.clear();
+	cnt.clear();
+	return 0;
+}
+
+int dp_table::add_source(int s, int t)
+{
+	assert(s >= lo && t <= hi);
+	assert(sources.size() == 0 || sources.back() < s);
+	sources.push_back(s);
+	targets.push_back(t);
+
+	int w = hi - lo + 1;
+	cnt.resize(sources.size() * w, 0);
+	if(cells.size() < sources.size() * w * k) cells.resize(sources.size() * w * k);
+	return 0;
+}
+
+entry* dp_table::at(int s, int r)
+{
+	return &cells[(s * (hi - lo + 1) + r - lo) * k];
+}
+
+int& dp_table::size(int s, int r)
+{
+	return cnt[s * (hi - lo + 1) + r - lo];
+}
+
+bridger::bridger(bundle_bridge *b, const genotype &g, const map<vector<int>, int> *js)
 	: gt(g)
 {
 	bd = b;
+	jshared = js;
 	max_pnode_length = 50;
 }
 
 int bridger::bridge()
 {
+	stage_timer st(STAGE_BRIDGER);
 	if (DEBUG_MODE_ON && print_bridger_detail)
 	{
 		printf("before bridging ... \n");
@@ -295,26 +338,20 @@ int bridger::build_path_nodes(int max_len)
 {
 	max_pnode_length = max_len;
 	map<vector<int>, int> m;
+
+	// allelic bridgers never touch non-allele-specific fragments,
+	// so their length-2 path nodes are counted once and shared
+	bool shared = (jshared != NULL && max_len == 2);
+	if(shared) m = *jshared;
+
 	for(int i = 0; i < bd->fragments.size(); i++)
 	{
 		// TODO, also check length
 		fragment &fr = bd->fragments[i];
 
 		if (gt_conflict(fr.gt, gt)) continue;
-		
-		if(fr.paths.size() == 1 && fr.paths[0].type == 1)
-		{
-			vector<int> v = decode_vlist(fr.paths[0].v);
-			if(v.size() <= 1) continue;
-			build_path_nodes(m, v, fr.cnt);		// TODO consider cnt of fragments
-		}
-		else
-		{
-			vector<int> v1 = decode_vlist(fr.h1->vlist);
-			vector<int> v2 = decode_vlist(fr.h2->vlist);
-			build_path_nodes(m, v1, fr.cnt);
-			build_path_nodes(m, v2, fr.cnt);
-		}
+		if (shared && !gt_implicit_same(fr.gt, gt)) continue;
+		build_path_nodes(m, fr);
 	}
 
 	pnodes.clear();
@@ -331,6 +368,38 @@ int bridger::build_path_nodes(int max_len)
 	return 0;
 }
 
+// length-2 path nodes of fragments conflicting with neither allele
+int bridger::build_shared_path_nodes(map<vector<int>, int> &m)
+{
+	max_pnode_length = 2;
+	for(int i = 0; i < bd->fragments.size(); i++)
+	{
+		fragment &fr = bd->fragments[i];
+		if (gt_conflict(fr.gt, ALLELE1)) continue;
+		if (gt_conflict(fr.gt, ALLELE2)) continue;
+		build_path_nodes(m, fr);
+	}
+	return 0;
+}
+
+int bridger::build_path_nodes(map<vector<int>, int> &m, const fragment &fr)
+{
+	if(fr.paths.size() == 1 && fr.paths[0].type == 1)
+	{
+		vector<int> v = decode_vlist(fr.paths[0].v);
+		if(v.size() <= 1) return 0;
+		build_path_nodes(m, v, fr.cnt);		// TODO consider cnt of fragments
+	}
+	else
+	{
+		vector<int> v1 = decode_vlist(fr.h1->vlist);
+		vector<int> v2 = decode_vlist(fr.h2->vlist);
+		build_path_nodes(m, v1, fr.cnt);
+		build_path_nodes(m, v2, fr.cnt);
+	}
+	return 0;
+}
+
 int bridger::build_path_nodes(map<vector<int>, int> &m, const vector<int> &v, int cnt)
 {
 	cnt = 1;
@@ -513,7 +582,7 @@ int bridger::bridge_hard_fragments()
 {
 	build_junction_graph();
 
-	if(use_overlap_scoring == true)  // default: false 
+	if(use_overlap_scoring == true)  // default: true 
 	{
 		build_path_nodes();
 		build_overlap_index();
@@ -548,23 +617,32 @@ int bridger::bridge_hard_fragments()
 		if(max_needed[x1] < x2) max_needed[x1] = x2;
 	}
 
-	vector< vector<entry> > table;
-	table.resize(bd->regions.size());
+	// start regions with overlapping windows are swept together, see build_dp_table
+	dp_table table;
+	table.init(0, -1, dp_solution_size);
+	int si = -1;
 	for(int k = 0; k < bd->regions.size(); k++)
 	{
 		if(affected[k].size() <= 0) continue;
 		if(max_needed[k] < k) continue;
 
-		dynamic_programming(k, max_needed[k], table);
+		si++;
+		if(si >= table.sources.size())
+		{
+			build_dp_table(k, affected, max_needed, table);
+			dynamic_programming(table);
+			si = 0;
+		}
+		assert(table.sources[si] == k);
 
 		// print table
 		/*
-		   printf("table from vertex %d to %d\n", k, max_needed);
-		   for(int j = k; j <= max_needed; j++)
+		   printf("table from vertex %d to %d\n", k, max_needed[k]);
+		   for(int j = k; j <= max_needed[k]; j++)
 		   {
-		   for(int i = 0; i < table[j].size(); i++)
+		   for(int i = 0; i < table.size(si, j); i++)
 		   {
-		   entry &e = table[j][i];
+		   entry &e = table.at(si, j)[i];
 		   printf("vertex %d, solution %d: ", j, i);
 		   e.print();
 		   }
@@ -580,9 +658,9 @@ int bridger::bridge_hard_fragments()
 			assert(j <= max_needed[k]);
 
 			if(j < k) continue;
-			if(table[j].size() == 0) continue;
+			if(table.size(si, j) == 0) continue;
 
-			vector< vector<int> > pb = trace_back(j, table);
+			vector< vector<int> > pb = trace_back(table, si, j);
 			vector< vector<int> > pn;
 			vector<int> ps;
 
@@ -626,7 +704,7 @@ int bridger::bridge_hard_fragments()
 			{
 				fragment *fr = fc.fset[i];
 
-				vector<int> best_stack;
+				const int *best_stack = NULL;
 				int best_score = -1;
 				int best_index = -1;
 
@@ -651,12 +729,12 @@ int bridger::bridge_hard_fragments()
 					if(ps[e] > best_score)
 					{
 						best_score = ps[e];
-						best_stack = table[j][e].stack;
+						best_stack = table.at(si, j)[e].stack;
 						best_index = e;
 					}
-					else if(ps[e] == best_score && compare_stack(table[j][e].stack, best_stack) >= 1)
+					else if(ps[e] == best_score && compare_stack(table.at(si, j)[e].stack, best_stack) >= 1)
 					{
-						best_stack = table[j][e].stack;
+						best_stack = table.at(si, j)[e].stack;
 						best_index = e;
 					}
 				}
@@ -692,7 +770,7 @@ int bridger::bridge_hard_fragments()
 			for(int e = 0; e < pb.size(); e++)
 			{
 				printf(" path %d, votes = %d, score = %d, stack = (", e, votes[e], ps[e]); 
-				printv(table[j][e].stack);
+				printv(table.at(si, j)[e].stack);
 				printf("), pb = (");
 				printv(pb[e]);
 				printf("), pn = (");
@@ -746,6 +824,26 @@ int bridger::compare_stack(const vector<int> &x, const vector<int> &y)
 	return 0;
 }
 
+int bridger::compare_stack(const int *x, const int *y)
+{
+	for(int i = 0; i < dp_stack_size; i++)
+	{
+		if(x[i] > y[i]) return +1;
+		if(x[i] < y[i]) return -1;
+	}
+	return 0;
+}
+
+// insert s into ascending stack x, keep the smallest dp_stack_size in y
+int bridger::update_stack(const int *x, int s, int *y)
+{
+	int p = 0;
+	for(; p < dp_stack_size && x[p] <= s; p++) y[p] = x[p];
+	if(p < dp_stack_size) y[p] = s;
+	for(int i = p + 1; i < dp_stack_size; i++) y[i] = x[i - 1];
+	return 0;
+}
+
 vector<int> bridger::update_stack(const vector<int> &v, int s)
 {
 	vector<int> stack(v.size(), 0);
@@ -761,46 +859,87 @@ vector<int> bridger::update_stack(const vector<int> &v, int s)
 	return stack;
 }
 
-int bridger::dynamic_programming(int k1, int k2, vector< vector<entry> > &table)
+// collect start regions from k1 on whose windows overlap, as long as the table stays small
+int bridger::build_dp_table(int k1, const vector< set<int> > &affected, const vector<int> &max_needed, dp_table &table)
 {
-	int n = bd->regions.size();
-	assert(k1 >= 0 && k1 < n);
-	assert(k2 >= 0 && k2 < n);
+	vector<int> v;
+	int hi = max_needed[k1];
+	for(int k = k1; k <= hi; k++)
+	{
+		if(affected[k].size() <= 0) continue;
+		if(max_needed[k] < k) continue;
+		int h = max_needed[k] > hi ? max_needed[k] : hi;
+		if(v.size() >= 1 && (v.size() + 1) * (h - k1 + 1) * dp_solution_size > MAX_DP_TABLE_SIZE) break;
+		v.push_back(k);
+		hi = h;
+	}
 
-	table.clear();
-	table.resize(n);
+	table.init(k1, hi, dp_solution_size);
+	for(int i = 0; i < v.size(); i++) table.add_source(v[i], max_needed[v[i]]);
+	return 0;
+}
 
-	table[k1].resize(1);
-	table[k1][0].stack.assign(dp_stack_size, 999999);
-	table[k1][0].length = bd->regions[k1].rpos - bd->regions[k1].lpos;
-	table[k1][0].trace1 = -1;
-	table[k1][0].trace2 = -1;
+// a single sweep over the window keeps the top-k paths from every start region
+int bridger::dynamic_programming(dp_table &table)
+{
+	int n = bd->regions.size();
+	assert(table.lo >= 0 && table.lo < n);
+	assert(table.hi >= 0 && table.hi < n);
 
-	for(int k = k1 + 1; k <= k2; k++)
+	for(int s = 0; s < table.sources.size(); s++)
+	{
+		int k1 = table.sources[s];
+		entry &e = table.at(s, k1)[0];
+		for(int i = 0; i < dp_stack_size; i++) e.stack[i] = 999999;
+		e.length = bd->regions[k1].rpos - bd->regions[k1].lpos;
+		e.trace1 = -1;
+		e.trace2 = -1;
+		table.size(s, k1) = 1;
+	}
+
+	for(int k = table.lo + 1; k <= table.hi; k++)
 	{
-		vector<entry> v;
 		int32_t len = bd->regions[k].rpos - bd->regions[k].lpos;
-		for(map<int, int>::reverse_iterator it = jsety[k].rbegin(); it != jsety[k].rend(); it++)
+		for(int s = 0; s < table.sources.size(); s++)
 		{
-			int j = it->first;
-			int w = it->second;
-			if(j < k1) continue;
-			if(table[j].size() == 0) continue;
+			int k1 = table.sources[s];
+			if(k1 >= k) break;
+			if(table.targets[s] < k) continue;
+
+			candidates.clear();
+			for(map<int, int>::reverse_iterator it = jsety[k].rbegin(); it != jsety[k].rend(); it++)
+			{
+				int j = it->first;
+				int w = it->second;
+				if(j >= k) continue;
+				if(j < k1) break;
 
-			for(int i = 0; i < table[j].size(); i++)
+				entry *x = table.at(s, j);
+				for(int i = 0; i < table.size(s, j); i++)
+				{
+					entry e;
+					update_stack(x[i].stack, w, e.stack);
+					e.length = x[i].length + len;
+					e.trace1 = j;
+					e.trace2 = i;
+					candidates.push_back(e);
+				}
+			}
+
+			int m = candidates.size();
+			if(m > table.k)
 			{
-				entry e;
-				e.stack = update_stack(table[j][i].stack, w);
-				e.length = table[j][i].length + len;
-				e.trace1 = j;
-				e.trace2 = i;
-				v.push_back(e);
+				partial_sort(candidates.begin(), candidates.begin() + table.k, candidates.end(), entry_compare);
+				m = table.k;
+			}
+			else
+			{
+				sort(candidates.begin(), candidates.end(), entry_compare);
 			}
-		}
 
-		sort(v.begin(), v.end(), entry_compare);
-		if(v.size() > dp_solution_size) v.resize(dp_solution_size);
-		table[k] = v;
+			copy(candidates.begin(), candidates.begin() + m, table.at(s, k));
+			table.size(s, k) = m;
+		}
 	}
 	return 0;
 }
@@ -932,10 +1071,10 @@ int32_t bridger::get_extended_length2(int k1, int p1, int p2)
 	return py.acc.back() - py.acc[k2];
 }
 
-vector< vector<int> > bridger::trace_back(int k, const vector< vector<entry> > &table)
+vector< vector<int> > bridger::trace_back(dp_table &table, int s, int k)
 {
 	vector< vector<int> > vv;
-	for(int i = 0; i < table[k].size(); i++)
+	for(int i = 0; i < table.size(s, k); i++)
 	{
 		vector<int> v;
 		int p = k;
@@ -943,7 +1082,7 @@ vector< vector<int> > bridger::trace_back(int k, const vector< vector<entry> > &
 		while(true)
 		{
 			v.push_back(p);
-			const entry &e = table[p][q];
+			const entry &e = table.at(s, p)[q];
 			p = e.trace1;
 			q = e.trace2;
 			if(p < 0) break;
@@ -1009,34 +1148,69 @@ int bridger::build_overlap_index()
 	for(int k = 0; k < pnodes.size(); k++) psetx[k].clear();
 	for(int k = 0; k < pnodes.size(); k++) psety[k].clear();
 
+	// vertices of a path node are increasing, so (vx, vy) overlap (type 1 of determine_overlap)
+	// iff the suffix of vx starting at vy[0] is a prefix of vy;
+	// index all prefixes by a rolling hash and look up every suffix instead of testing all pairs
+	const size_t base = 1000003;
+	unordered_map<size_t, vector<int> > prefixes;
+	for(int j = 0; j < pnodes.size(); j++)
+	{
+		const vector<int> &vy = pnodes[j].v;
+		size_t h = 0;
+		for(int k = 0; k < vy.size(); k++)
+		{
+			h = h * base + vy[k] + 1;
+			prefixes[h].push_back(j);
+		}
+	}
+
 	int cnt1 = 0;
+	vector<size_t> hx;
+	vector<size_t> px;
 	for(int i = 0; i < pnodes.size(); i++)
 	{
 		const vector<int> &vx = pnodes[i].v;
-		for(int j = i + 1; j < pnodes.size(); j++)
+		int n = vx.size();
+		hx.assign(n + 1, 0);
+		px.assign(n + 1, 1);
+		for(int k = 0; k < n; k++)
+		{
+			hx[k + 1] = hx[k] * base + vx[k] + 1;
+			px[k + 1] = px[k] * base;
+		}
+
+		for(int kx = 0; kx < n; kx++)
 		{
-			const vector<int> &vy = pnodes[j].v;
-
-			PI p;
-			int t = determine_overlap(vx, vy, p);
-			if(t != 1) continue;
-			assert(p.first >= 0 && p.first < vx.size());
-			assert(p.second >= 0 && p.second < vy.size());
-
-			//int32_t len2 = pnodes[j].acc.back() - pnodes[j].acc[p.second];
-			//int32_t len1 = (p.first == 0) ? 0 : pnodes[i].acc[p.first - 1];
-
-			// pset1 & 2 are full
-			//pset1[i].insert(pair<int, int>(j, p.second));
-			//pset2[j].insert(pair<int, int>(i, p.first));
-
-			// psetx & y are not full
-			// consider only (1,2,3) -> (2,3,4)
-			//if(p.first == 0) continue;
-			//if(p.second == vy.size() - 1) continue;
-			psetx[i].insert(pair<int, int>(j, p.second));
-			psety[j].insert(pair<int, int>(i, p.first));
-			cnt1++;
+			size_t h = hx[n] - hx[kx] * px[n - kx];
+			unordered_map<size_t, vector<int> >::iterator it = prefixes.find(h);
+			if(it == prefixes.end()) continue;
+
+			for(int e = 0; e < it->second.size(); e++)
+			{
+				int j = it->second[e];
+				if(j <= i) continue;
+
+				const vector<int> &vy = pnodes[j].v;
+				if(vy.size() < n - kx) continue;
+				if(equal(vx.begin() + kx, vx.end(), vy.begin()) == false) continue;
+
+				PI p(kx, n - kx - 1);
+
+				//int32_t len2 = pnodes[j].acc.back() - pnodes[j].acc[p.second];
+				//int32_t len1 = (p.first == 0) ? 0 : pnodes[i].acc[p.first - 1];
+
+				// pset1 & 2 are full
+				//pset1[i].insert(pair<int, int>(j, p.second));
+				//pset2[j].insert(pair<int, int>(i, p.first));
+
+				// psetx & y are not full
+				// consider only (1,2,3) -> (2,3,4)
+				//if(p.first == 0) continue;
+				//if(p.second == vy.size() - 1) continue;
+				psetx[i].insert(pair<int, int>(j, p.second));
+				psety[j].insert(pair<int, int>(i, p.first));
+				cnt1++;
+			}
 		}
 	}
 
@@ -1380,11 +1554,11 @@ int bridger::determine_overlap1(const vector<int> &vx, const vector<int> &vy, PI
 
 int bridger::update_length()
 {
-	length_median = insertsize_median;
+	length_median = bd->rc.insertsize_median;
 	length_high = length_median * 3.0;
 	length_low = length_median * 0.3;
-	if(length_low < insertsize_low) length_low = insertsize_low;
-	if(length_high > insertsize_high) length_high = insertsize_high;
+	if(length_low < bd->rc.insertsize_low) length_low = bd->rc.insertsize_low;
+	if(length_high > bd->rc.insertsize_high) length_high = bd->rc.insertsize_high;
 	return 0;
 
 	// TODO
@@ -1481,6 +1655,7 @@ int bridger::get_paired_fragments()
 	int n2 = 0;
 	for(int k = 0; k < bd->fragments.size(); k++)
 	{
+		if (!gt_implicit_same(bd->fragments[k].gt, gt)) continue;  // the other allele may be bridged concurrently
 		if(bd->fragments[k].paths.size() >= 1) n1++;
 		if(bd->fragments[k].paths.size() != 1) continue;
 		if(bd->fragments[k].paths[0].type != 1) continue;
@@ -11,16 +11,17 @@ See LICENSE for licensing.
 
 #include "bundle_bridge.h"
 #include "fcluster.h"
+#include "config.h"
 
 using namespace std;
 
 class entry
 {
 public:
-	vector<int> stack;
+	int stack[MAX_DP_STACK_SIZE];	// smallest junction weights along the path, ascending; first dp_stack_size used
 	int32_t length;
-	int trace1;
-	int trace2;
+	int trace1;						// previous region
+	int trace2;						// solution index at previous region
 
 public:
 	int print();
@@ -28,15 +29,39 @@ public:
 
 bool entry_compare(const entry &x, const entry &y);
 
+/*
+** top-k bridging table of a batch of start regions sharing one window of regions;
+** solutions of (source s, region r) are stored in cells[(s * (hi - lo + 1) + r - lo) * k ...], 
+** and cnt[s * (hi - lo + 1) + r - lo] of them are valid
+*/
+class dp_table
+{
+public:
+	int lo;							// first region of the window
+	int hi;							// last region of the window
+	int k;							// max number of solutions kept for each region
+	vector<int> sources;			// start regions, ascending
+	vector<int> targets;			// last region needed for each start region
+	vector<entry> cells;
+	vector<int> cnt;
+
+public:
+	int init(int _lo, int _hi, int _k);
+	int add_source(int s, int t);
+	entry* at(int s, int r);
+	int& size(int s, int r);
+};
+
 class bridger
 {
 public:
-	bridger(bundle_bridge *b, const genotype &_gt);
+	bridger(bundle_bridge *b, const genotype &_gt, const map<vector<int>, int> *js = NULL);
 
 public:
 	bundle_bridge *bd;				// parent bundle
 	genotype gt;					// to be bridged phase
 	vector<path> pnodes;			// path nodes 
+	const map<vector<int>, int> *jshared;	// length-2 path nodes of non-allele-specific fragments, shared by allelic bridgers
 	vector< map<int, int> > jsetx;	// junction graph (out) 
 	vector< map<int, int> > jsety;	// junction graph (in)
 	vector< map<int, int> > psetx;	// path graph (out)
@@ -45,7 +70,7 @@ public:
 	int32_t length_median;
 	int32_t length_low;
 	int32_t length_high;
-
+	vector<entry> candidates;		// buffer of dp candidates of one region
 
 public:
 	int bridge();
@@ -64,8 +89,9 @@ public:
 	
 	int build_junction_graph();
 	int bridge_hard_fragments();
-	int dynamic_programming(int k1, int k2, vector< vector<entry> > &table);
-	vector< vector<int> > trace_back(int k, const vector< vector<entry> > &table);
+	int build_dp_table(int k1, const vector< set<int> > &affected, const vector<int> &max_needed, dp_table &table);
+	int dynamic_programming(dp_table &table);
+	vector< vector<int> > trace_back(dp_table &table, int s, int k);
 	int evaluate_bridging_path(const vector<int> &pb);
 	int determine_overlap(const vector<int> &vx, const vector<int> &vy, PI &p);
 	int determine_overlap1(const vector<int> &vx, const vector<int> &vy, PI &p);
@@ -75,7 +101,9 @@ public:
 	// int bridge_tough_fragments();
 	int dynamic_programming(int k1, int k2, vector<int> &trace, vector< vector<int> > &table_cov, vector<int32_t> &table_len);
 	int compare_stack(const vector<int> &x, const vector<int> &y);
+	int compare_stack(const int *x, const int *y);
 	vector<int> update_stack(const vector<int> &v, int s);
+	int update_stack(const int *x, int s, int *y);
 
 	vector<int> trace_back(int k1, int k2, const vector<int> &trace);
 	// vector<int> get_bridge(const vector<int> &vv, const vector<int> &v1, const vector<int> &v2);
@@ -89,6 +117,8 @@ public:
 	int build_path_nodes(int max_len);
 	int build_path_nodes(int low, int high);
 	int build_path_nodes(map<vector<int>, int> &m, const vector<int> &v, int cnt);
+	int build_path_nodes(map<vector<int>, int> &m, const fragment &fr);
+	int build_shared_path_nodes(map<vector<int>, int> &m);
 	int add_consecutive_path_nodes();
 	// int adjust_path_score(path &p);
 
@@ -26,11 +26,12 @@ See LICENSE for licensing.
 #include "as_pos.hpp"
 #include "as_pos32.hpp"
 #include "interval_map.h"
+#include "run_stats.h"
 
 using namespace std;
 
-bundle::bundle(bundle_base &b)
-	: bb(b), br(b)
+bundle::bundle(bundle_base &b, const run_config &r)
+	: bb(b), rc(r), br(b, r), num_vertices0(0), num_edges0(0)
 {
 	br.build();
 	prepare();
@@ -42,18 +43,31 @@ bundle::~bundle()
 
 int bundle::prepare()
 {
+	stage_timer st(STAGE_BUNDLE);
 	compute_strand();
 	build_intervals();
 	build_partial_exons();
 	build_pos_pids_map();
 	build_pseudo_variant_exon();
 	pexon_jset(jset);
+
+	// everything below does not depend on mode, compute it once for both graphs
+	build_splice_graph_base();
+	build_hyper_set();
+	if(to_revise_splice_graph)
+	{
+		count_broken_boundaries(points);
+		count_false_boundaries(fb1, fb2);
+	}
 	return 0;
 }
 
 int bundle::build(int mode, bool revise)
 {
+	stage_timer st(STAGE_BUNDLE);
 	build_splice_graph(mode);
+	num_vertices0 = gr.num_vertices();
+	num_edges0 = gr.num_edges();
 
 	if(revise && to_revise_splice_graph)  
 	{
@@ -65,15 +79,13 @@ int bundle::build(int mode, bool revise)
 		gr.keep_surviving_edges();
 		gr.refine_splice_graph();
 	}
-	
-	build_hyper_set();
 	return 0;
 }
 
 int bundle::compute_strand()
 {
-	if(library_type != UNSTRANDED) assert(bb.strand != '.');
-	if(library_type != UNSTRANDED) return 0;
+	if(rc.library_type != UNSTRANDED) assert(bb.strand != '.');
+	if(rc.library_type != UNSTRANDED) return 0;
 
 	int n0 = 0, np = 0, nq = 0;
 	for(int i = 0; i < bb.hits.size(); i++)
@@ -90,15 +102,17 @@ int bundle::compute_strand()
 	return 0;
 }
 
+// bridged fragments and the remaining hits are swept once into fmap
 int bundle::build_intervals()
 {
-	fmap.clear();
-	set<hit*> added_hit;
+	vector< pair<int32_t, int> > events;
+	vector<bool> added_hit(bb.hits.size(), false);
+	vector<as_pos32> vv;
 	for(int i = 0; i < br.fragments.size(); i++)
 	{
 		fragment &fr = br.fragments[i];
 		if(fr.paths.size() != 1 || fr.paths[0].type != 1) continue;
-		const vector<as_pos32>& vv = br.get_aligned_intervals(fr);
+		br.get_aligned_intervals(fr, vv);
 		if(vv.size() <= 0) continue;
 		assert(vv.size() % 2 == 0);
 
@@ -118,18 +132,20 @@ int bundle::build_intervals()
 		{
 			int32_t p = vv[2 * k + 0];
 			int32_t q = vv[2 * k + 1];
-			fmap += make_pair(ROI(p, q), 1);
+			if(p >= q) continue;
+			events.push_back(pair<int32_t, int>(p, 1));
+			events.push_back(pair<int32_t, int>(q, -1));
 			// if (DEBUG_MODE_ON && verbose >= 10) cout <<"itv added" << p << "-" << q << endl;
 		}
-		added_hit.insert(fr.h1);
-		added_hit.insert(fr.h2);
+		added_hit[fr.h1 - &bb.hits[0]] = true;
+		added_hit[fr.h2 - &bb.hits[0]] = true;
 	}
 
 	for(int i = 0; i < bb.hits.size(); i++)
 	{
 		hit &ht = bb.hits[i];
 		if((ht.flag & 0x100) >= 1 && !use_second_alignment) continue;
-		if(added_hit.find(&ht) != added_hit.end()) continue;
+		if(added_hit[i] == true) continue;
 		// if(ht.bridged == true) continue;
 		// if(br.breads.find(ht.qname) != br.breads.end()) continue;
 
@@ -137,11 +153,15 @@ int bundle::build_intervals()
 		{
 			int32_t s = high32(ht.itv_align[k]);
 			int32_t t = low32(ht.itv_align[k]);
-			fmap += make_pair(ROI(s, t), 1);
+			if(s >= t) continue;
+			events.push_back(pair<int32_t, int>(s, 1));
+			events.push_back(pair<int32_t, int>(t, -1));
 		}
 		// cout << ht.qname << "unbridged itv size=" << ht.itv_align.size() << endl;
 		// ht.print();
 	}
+
+	build_flat_interval_map(events, fmap);
 	return 0;
 }
 
@@ -157,13 +177,14 @@ int bundle::build_partial_exons()
 	}
 
 	vector<region>& regions = br.regions;
-	// add non-AS pexons
+	// add non-AS pexons; regions are sorted, so their coverage is read in one pass over fmap
+	FIMI hint = fmap.begin();
 	for (int i = 0; i < regions.size(); i++)
 	{
 		region& r =  regions[i];
 		if(r.is_allelic()) continue;
 		
-		r.rebuild(&fmap); 
+		r.rebuild(fmap, hint); 
 		for(int k = 0; k < r.pexons.size(); k++)
 		{
 			partial_exon& rpe = r.pexons[k];
@@ -546,24 +567,79 @@ vector<int> bundle::align_fragment(fragment &fr)
 	else return sp2;
 }
 
-int bundle::build_splice_graph(int mode)
+int bundle::build_splice_graph_base()
 {	
 	gr.clear();
 	if (verbose >= 3) 
 		cout << "splice graph build for bundle " << bb.chrm << ":" << bb.lpos << "-" << bb.rpos << " " <<bb.strand << " strand" << endl;
 	
-	build_splice_graph_vertices(mode);
-	build_splice_graph_edges(mode);
-	build_splice_graph_vertices_as_type(mode);
+	build_splice_graph_vertices();
+	build_splice_graph_edges();
+	build_splice_graph_vertices_as_type();
 	build_regional();
 
 	gr.strand = bb.strand;
 	gr.chrm = bb.chrm;
 
+	MEE x2y, y2x;
+	gr0.copy(gr, x2y, y2x);
 	return 0;
 }
 
-int bundle::build_splice_graph_vertices(int mode)
+// only vertex weights and the weights of edges from source / to sink depend on mode
+int bundle::build_splice_graph(int mode)
+{
+	MEE x2y, y2x;
+	gr.copy(gr0, x2y, y2x);
+
+	for(int i = 0; i < pexons.size(); i++) 
+	{
+		const partial_exon &r = pexons[i];
+		if(mode == 1) gr.set_vertex_weight(i + 1, r.max < min_guaranteed_edge_weight ? min_guaranteed_edge_weight : r.max);
+		if(mode == 2) gr.set_vertex_weight(i + 1, r.ave < min_guaranteed_edge_weight ? min_guaranteed_edge_weight : r.ave);
+		if(r.type == PSEUDO_AS_VERTEX) gr.set_vertex_weight(i + 1, min_guaranteed_edge_weight);
+	}
+
+	PEEI pi = gr.out_edges(0);
+	for(edge_iterator it = pi.first; it != pi.second; it++)
+	{
+		int i = (*it)->target() - 1;
+		const partial_exon &r = pexons[i];
+		double w = min_guaranteed_edge_weight;
+		if(mode == 1) w = r.max;
+		if(mode == 2) w = r.ave;
+		if(mode == 1 && i >= 1 && pexons[i - 1].rpos.p32 == r.lpos.p32) w -= pexons[i - 1].max;
+		if(mode == 2 && i >= 1 && pexons[i - 1].rpos.p32 == r.lpos.p32) w -= pexons[i - 1].ave;
+		if(w < min_guaranteed_edge_weight) w = min_guaranteed_edge_weight;
+
+		gr.set_edge_weight(*it, w);
+		edge_info ei = gr.get_edge_info(*it);
+		ei.weight = w;
+		gr.set_edge_info(*it, ei);
+	}
+
+	PEEI po = gr.in_edges(pexons.size() + 1);
+	for(edge_iterator it = po.first; it != po.second; it++)
+	{
+		int i = (*it)->source() - 1;
+		const partial_exon &r = pexons[i];
+		double w = min_guaranteed_edge_weight;
+		if(mode == 1) w = r.max;
+		if(mode == 2) w = r.ave;
+		if(mode == 1 && i < pexons.size() - 1 && pexons[i + 1].lpos.p32 == r.rpos.p32) w -= pexons[i + 1].max;
+		if(mode == 2 && i < pexons.size() - 1 && pexons[i + 1].lpos.p32 == r.rpos.p32) w -= pexons[i + 1].ave;
+		if(w < min_guaranteed_edge_weight) w = min_guaranteed_edge_weight;
+
+		gr.set_edge_weight(*it, w);
+		edge_info ei = gr.get_edge_info(*it);
+		ei.weight = w;
+		gr.set_edge_info(*it, ei);
+	}
+
+	return 0;
+}
+
+int bundle::build_splice_graph_vertices()
 {
 	// vertices: start, each region, end
 	gr.add_vertex();
@@ -582,9 +658,7 @@ int bundle::build_splice_graph_vertices(int mode)
 		int length = r.rpos.p32 - r.lpos.p32;
 		assert(length >= 1);
 		gr.add_vertex();
-		if(mode == 1) gr.set_vertex_weight(i + 1, r.max < min_guaranteed_edge_weight ? min_guaranteed_edge_weight : r.max);
-		if(mode == 2) gr.set_vertex_weight(i + 1, r.ave < min_guaranteed_edge_weight ? min_guaranteed_edge_weight : r.ave);
-		if(r.type == PSEUDO_AS_VERTEX) gr.set_vertex_weight(i + 1, min_guaranteed_edge_weight);
+		gr.set_vertex_weight(i + 1, min_guaranteed_edge_weight);
 		vertex_info vi;
 		vi.lpos = r.lpos;
 		vi.rpos = r.rpos;
@@ -607,7 +681,7 @@ int bundle::build_splice_graph_vertices(int mode)
 	return 0;
 }
 
-int bundle::build_splice_graph_edges(int mode)
+int bundle::build_splice_graph_edges()
 {
 	// edges: each jset_pair => and e2w;  including adjacent pexons, excld PSEUDO_AS_VERTEX
 	for(const auto& jset_item: jset)
@@ -647,8 +721,8 @@ int bundle::build_splice_graph_edges(int mode)
 		assert(counter_v_id > 0);
 		assert(counter_v_id < gr.num_vertices() - 1);
 
-		add_pseudo_as_in_edge(mode, k, counter_v_id);
-		add_pseudo_as_out_edge(mode, k, counter_v_id);
+		add_pseudo_as_in_edge(k, counter_v_id);
+		add_pseudo_as_out_edge(k, counter_v_id);
 	}
 
 
@@ -688,7 +762,7 @@ int bundle::build_splice_graph_edges(int mode)
 		}
 	}
 
-	// edges: connecting start/end and pexons
+	// edges: connecting start/end and pexons; weights are assigned per mode
 	int ss = 0;
 	int tt = pexons.size() + 1;
 	for(int i = 0; i < pexons.size(); i++)
@@ -700,12 +774,6 @@ int bundle::build_splice_graph_edges(int mode)
 			r.ltype = START_BOUNDARY;
 			edge_descriptor p = gr.add_edge(ss, i + 1);
 			double w = min_guaranteed_edge_weight;
-			if(mode == 1) w = r.max;
-			if(mode == 2) w = r.ave;
-			if(mode == 1 && i >= 1 && pexons[i - 1].rpos.p32 == r.lpos.p32) w -= pexons[i - 1].max;
-			if(mode == 2 && i >= 1 && pexons[i - 1].rpos.p32 == r.lpos.p32) w -= pexons[i - 1].ave;
-			if(w < min_guaranteed_edge_weight) w = min_guaranteed_edge_weight;
-
 			gr.set_edge_weight(p, w);
 			edge_info ei;
 			ei.weight = w;
@@ -717,11 +785,6 @@ int bundle::build_splice_graph_edges(int mode)
 			r.rtype = END_BOUNDARY;
 			edge_descriptor p = gr.add_edge(i + 1, tt);
 			double w = min_guaranteed_edge_weight;
-			if(mode == 1) w = r.max;
-			if(mode == 2) w = r.ave;
-			if(mode == 1 && i < pexons.size() - 1 && pexons[i + 1].lpos.p32 == r.rpos.p32) w -= pexons[i + 1].max;
-			if(mode == 2 && i < pexons.size() - 1 && pexons[i + 1].lpos.p32 == r.rpos.p32) w -= pexons[i + 1].ave;
-			if(w < min_guaranteed_edge_weight) w = min_guaranteed_edge_weight;
 			gr.set_edge_weight(p, w);
 			edge_info ei;
 			ei.weight = w;
@@ -732,7 +795,7 @@ int bundle::build_splice_graph_edges(int mode)
 	return 0;
 }
 
-int bundle::add_pseudo_as_in_edge(int mode, int pse_id, int counter_v_id)
+int bundle::add_pseudo_as_in_edge(int pse_id, int counter_v_id)
 {
 	int k = pse_id;
 
@@ -783,7 +846,7 @@ int bundle::add_pseudo_as_in_edge(int mode, int pse_id, int counter_v_id)
 	return 0;
 }
 
-int bundle::add_pseudo_as_out_edge(int mode, int pse_id, int counter_v_id)
+int bundle::add_pseudo_as_out_edge(int pse_id, int counter_v_id)
 {
 	int k = pse_id;
 
@@ -834,7 +897,7 @@ int bundle::add_pseudo_as_out_edge(int mode, int pse_id, int counter_v_id)
 	return 0;
 }
 
-int bundle::build_splice_graph_vertices_as_type(int mode)
+int bundle::build_splice_graph_vertices_as_type()
 {	
 	// vertices: for each vertex, incld PSEUDO_AS_VERTEX
 	for(int i = 1; i < gr.num_vertices() - 1 ; i++) 
@@ -919,38 +982,50 @@ int bundle::revise_splice_graph()
 	b = gr.keep_surviving_edges();		// removes non-surviving psuedo as pexon edges
 	if(b == true) gr.refine_splice_graph();
 
+	// read support of boundaries (points, fb1, fb2) is counted once in prepare()
+	// each rule only examines vertices touched (logged in gr.rlog) since its last examination
+	gr.rlog.clear();
+	for(int i = 1; i < gr.num_vertices() - 1; i++) gr.rlog.push_back(i);
+	vector<int> k(10, 0);
+
 	while(true)
 	{
-		b = tackle_false_boundaries();
+		b = tackle_false_boundaries(points, gr.touched_vertices(k[0]));
 		if(b == true) continue;
 
-		b = remove_false_boundaries();
+		b = remove_false_boundaries(fb1, fb2, gr.touched_vertices(k[1]));
 		if(b == true) continue;
 
-		b = gr.remove_inner_boundaries();
+		b = gr.remove_inner_boundaries(gr.touched_vertices(k[2]));
 		if(b == true) continue;
 
-		b = gr.remove_small_exons();
+		b = gr.remove_small_exons(gr.touched_vertices(k[3]));
 		if(b == true) continue;
 
-		b = gr.remove_intron_contamination();
+		b = gr.remove_intron_contamination(gr.touched_vertices(k[4]));
 		if(b == true) continue;
 
-		b = gr.remove_small_junctions();
+		b = gr.remove_small_junctions(gr.touched_vertices(k[5]));
 		if(b == true) gr.refine_splice_graph();
 		if(b == true) continue;
 
-		b = gr.extend_start_boundaries();
+		b = gr.extend_start_boundaries(gr.touched_vertices(k[6]));
 		if(b == true) continue;
 
-		b = gr.extend_end_boundaries();
+		b = gr.extend_end_boundaries(gr.touched_vertices(k[7]));
 		if(b == true) continue;
 
-		b = gr.extend_boundaries();
+		b = gr.extend_boundaries(gr.touched_vertices(k[8]));
 		if(b == true) gr.refine_splice_graph();
 		if(b == true) continue;
 
-		b = gr.keep_surviving_edges();
+		// keep_surviving_edges is not local; rerun it only if the graph is changed since
+		b = false;
+		if(k[9] < gr.rlog.size())
+		{
+			k[9] = gr.rlog.size();
+			b = gr.keep_surviving_edges();
+		}
 		if(b == true) gr.refine_splice_graph();
 		if(b == true) continue;
 
@@ -968,10 +1043,11 @@ int bundle::revise_splice_graph()
 }
 
 // add by Mingfu -- to use paired-end reads to remove false boundaries
-bool bundle::remove_false_boundaries()
+// fb1: reads supporting false end boundaries; fb2: reads supporting false start boundaries
+int bundle::count_false_boundaries(map<int, int> &fb1, map<int, int> &fb2)
 {
-	map<int, int> fb1;		// end
-	map<int, int> fb2;		// start
+	fb1.clear();
+	fb2.clear();
 	for(int i = 0; i < br.fragments.size(); i++)
 	{
 		fragment &fr = br.fragments[i];
@@ -1008,8 +1084,8 @@ bool bundle::remove_false_boundaries()
 		if(u1 < 0 || u2 < 0) continue;
 		if(u1 >= u2) continue;
 
-		const vertex_info v1 = gr.get_vertex_info(u1);
-		const vertex_info v2 = gr.get_vertex_info(u2);
+		const vertex_info &v1 = gr.get_vertex_info(u1);
+		const vertex_info &v2 = gr.get_vertex_info(u2);
 
 		int types = 0;
 		int32_t lengths = 0;
@@ -1039,12 +1115,20 @@ bool bundle::remove_false_boundaries()
 			else fb2.insert(make_pair(u2, 1));
 		}
 	}
+	return 0;
+}
 
+// mark vertices in vs as empty if they are false boundaries, i.e., in fb1/fb2 with enough reads
+bool bundle::remove_false_boundaries(const map<int, int> &fb1, const map<int, int> &fb2, const set<int> &vs)
+{
 	bool b = false;
-	for(auto &x : fb1)
+	for(int v : vs)
 	{
+		auto it = fb1.find(v);
+		if(it == fb1.end()) continue;
+		const pair<const int, int> &x = *it;
 		PEB p = gr.edge(x.first, gr.num_vertices() - 1);
-		vertex_info vi = gr.get_vertex_info(x.first);
+		const vertex_info &vi = gr.get_vertex_info(x.first);
 		if(vi.type == EMPTY_VERTEX) continue;
 		if(p.second == false) continue;
 		double w = gr.get_vertex_weight(x.first);
@@ -1053,15 +1137,18 @@ bool bundle::remove_false_boundaries()
 		if(s > 1.5) continue;
 		if(verbose >= 2) printf("detect false end boundary %d with %d reads, vertex = %d, w = %.2lf, type = %d, z = %.2lf, s = %.2lf\n", vi.rpos.p32, x.second, x.first, w, vi.type, z, s); 
 		//gr.remove_edge(p.first);
-		vi.type = EMPTY_VERTEX;
-		gr.set_vertex_info(x.first, vi);
+		gr.vinf[x.first].type = EMPTY_VERTEX;
+		gr.touch_vertex(x.first);
 		b = true;
 	}
 
-	for(auto &x : fb2)
+	for(int v : vs)
 	{
+		auto it = fb2.find(v);
+		if(it == fb2.end()) continue;
+		const pair<const int, int> &x = *it;
 		PEB p = gr.edge(0, x.first);
-		vertex_info vi = gr.get_vertex_info(x.first);
+		const vertex_info &vi = gr.get_vertex_info(x.first);
 		if(vi.type == EMPTY_VERTEX) continue;
 		if(p.second == false) continue;
 		double w = gr.get_vertex_weight(x.first);
@@ -1070,17 +1157,17 @@ bool bundle::remove_false_boundaries()
 		if(s > 1.5) continue;
 		if(verbose >= 2) printf("detect false start boundary %d with %d reads, vertex = %d, w = %.2lf, type = %d, z = %.2lf, s = %.2lf\n", vi.lpos.p32, x.second, x.first, w, vi.type, z, s); 
 		//gr.remove_edge(p.first);
-		vi.type = EMPTY_VERTEX;
-		gr.set_vertex_info(x.first, vi);
+		gr.vinf[x.first].type = EMPTY_VERTEX;
+		gr.touch_vertex(x.first);
 		b = true;
 	}
 	return b;
 }
 
-bool bundle::tackle_false_boundaries()
+// points[k]: number of fragments breaking pexon k as an end/start boundary
+int bundle::count_broken_boundaries(vector<int> &points)
 {
-	bool b = false;
-	vector<int> points(pexons.size(), 0);
+	points.assign(pexons.size(), 0);
 	for(int k = 0; k < br.fragments.size(); k++)
 	{
 		fragment &fr = br.fragments[k];
@@ -1117,8 +1204,8 @@ bool bundle::tackle_false_boundaries()
 		}
 		*/
 
-		if(tlen < insertsize_low / 2.0) continue;
-		if(tlen > insertsize_high * 2.0) continue;
+		if(tlen < rc.insertsize_low / 2.0) continue;
+		if(tlen > rc.insertsize_high * 2.0) continue;
 		if(tlen >= fr.paths[0].length) continue;
 
 		for(int i = 0; i < v.size() - 1; i++)
@@ -1137,11 +1224,19 @@ bool bundle::tackle_false_boundaries()
 			}
 		}
 	}
+	return 0;
+}
 
-	for(int k = 0; k < points.size(); k++)
+// mark vertices in vs as empty if they are boundaries broken by enough fragments
+bool bundle::tackle_false_boundaries(const vector<int> &points, const set<int> &vs)
+{
+	bool b = false;
+	for(int v : vs)
 	{
+		int k = v - 1;
+		if(k < 0 || k >= points.size()) continue;
 		if(points[k] <= 0) continue;
-		vertex_info vi = gr.get_vertex_info(k + 1);
+		const vertex_info &vi = gr.get_vertex_info(k + 1);
 		if(vi.type == EMPTY_VERTEX) continue;
 		PEB p = gr.edge(k + 1, gr.num_vertices() - 1);
 		if(p.second == false) continue;
@@ -1150,15 +1245,17 @@ bool bundle::tackle_false_boundaries()
 		double s = log(1 + w) - log(1 + points[k]);
 		if(verbose >= 2) printf("tackle false end boundary %d with %d reads, vertex = %d, w = %.2lf, z = %.2lf, s = %.2lf\n", pexons[k].rpos.p32, points[k], k + 1, w, z, s);
 		if(s > 1.5) continue;
-		vi.type = EMPTY_VERTEX;
-		gr.set_vertex_info(k + 1, vi);
+		gr.vinf[k + 1].type = EMPTY_VERTEX;
+		gr.touch_vertex(k + 1);
 		b = true;
 	}
 
-	for(int k = 0; k < points.size(); k++)
+	for(int v : vs)
 	{
+		int k = v - 1;
+		if(k < 0 || k >= points.size()) continue;
 		if(points[k] <= 0) continue;
-		vertex_info vi = gr.get_vertex_info(k + 1);
+		const vertex_info &vi = gr.get_vertex_info(k + 1);
 		if(vi.type == EMPTY_VERTEX) continue;
 		PEB p = gr.edge(0, k + 1);
 		if(p.second == false) continue;
@@ -1167,8 +1264,8 @@ bool bundle::tackle_false_boundaries()
 		double s = log(1 + w) - log(1 + points[k]);
 		if(verbose >= 2) printf("tackle false start boundary %d with %d reads, vertex = %d, w = %.2lf, z = %.2lf, s = %.2lf\n", pexons[k].lpos.p32, points[k], k + 1, w, z, s);
 		if(s > 1.5) continue;
-		vi.type = EMPTY_VERTEX;
-		gr.set_vertex_info(k + 1, vi);
+		gr.vinf[k + 1].type = EMPTY_VERTEX;
+		gr.touch_vertex(k + 1);
 		b = true;
 	}
 
@@ -1198,7 +1295,7 @@ int bundle::print(int index)
 
 	// print fmap
 	/*
-	for(JIMI it = fmap.begin(); it != fmap.end(); it++)
+	for(FIMI it = fmap.begin(); it != fmap.end(); it++)
 	{
 		printf("bundle.fmap %d: jmap [%d%s, %d%s) -> %d\n", 
 			index, lower(it->first).p32, lower(it->first).ale.c_str(), upper(it->first).p32, upper(it->first).ale.c_str(), it->second);
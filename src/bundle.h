@@ -28,13 +28,14 @@ using namespace std;
 class bundle
 {
 public:
-	bundle(bundle_base &bb);
+	bundle(bundle_base &bb, const run_config &rc);
 	virtual ~bundle();
 
 public:
 	bundle_base &bb;															// input bundle base	
+	const run_config &rc;														// library type and insert sizes
 	bundle_bridge br;															// contains fragments
-	split_interval_map fmap;													// matched interval map, not AS. (alleles collapsed)
+	flat_interval_map fmap;														// matched interval map, not AS. (alleles collapsed)
 
 	/* 
 	** re-use from bundle_bridge
@@ -48,8 +49,14 @@ public:
 	map<pair<int32_t, int32_t>, vector<int> > pos_pids;							// pos pair to partial exon ids, allelic pexons are put in vector
 	vector<bool> regional;														// if a pe is regional
 	map<pair<int, int>, int > jset;											    // < <pid-to-pid, hit-counts>
+	splice_graph gr0;															// splice graph shared by all modes, w/o mode-specific weights
 	splice_graph gr;															// splice graph
 	hyper_set hs;																// hyper set
+	vector<int> points;															// fragments breaking each pexon as a boundary
+	map<int, int> fb1;															// reads supporting false end boundaries
+	map<int, int> fb2;															// reads supporting false start boundaries
+	int num_vertices0;															// vertices of gr before revision
+	int num_edges0;																// edges of gr before revision
 
 public:
 	virtual int build(int mode, bool revise);
@@ -68,22 +75,25 @@ public:
 	int build_pos_pids_map();
 	int build_pseudo_variant_exon();
 	int pexon_jset(map<pair<int, int>, int >& pexon_jset);
+	int build_splice_graph_base();
 	int build_splice_graph(int mode);
 
 	// revise splice graph 
 	int revise_splice_graph();
-	bool remove_false_boundaries();
-	bool tackle_false_boundaries();
+	int count_false_boundaries(map<int, int> &fb1, map<int, int> &fb2);
+	bool remove_false_boundaries(const map<int, int> &fb1, const map<int, int> &fb2, const set<int> &vs);
+	int count_broken_boundaries(vector<int> &points);
+	bool tackle_false_boundaries(const vector<int> &points, const set<int> &vs);
 	
 	// hyper set
 	int build_hyper_set();
 
 private:
-	int build_splice_graph_vertices(int mode);
-	int build_splice_graph_edges(int mode);
-	int add_pseudo_as_in_edge(int mode, int pse_id, int counter_v_id);
-	int add_pseudo_as_out_edge(int mode, int pse_id, int counter_v_id);
-	int build_splice_graph_vertices_as_type(int mode);
+	int build_splice_graph_vertices();
+	int build_splice_graph_edges();
+	int add_pseudo_as_in_edge(int pse_id, int counter_v_id);
+	int add_pseudo_as_out_edge(int pse_id, int counter_v_id);
+	int build_splice_graph_vertices_as_type();
 	int build_regional();
 	vector<int> align_hit(hit &h);
 	vector<int> align_fragment(fragment &f);
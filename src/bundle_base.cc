@@ -23,6 +23,7 @@ bundle_base::bundle_base()
 	rpos = 0;
 	strand = '.';
 	is_allelic = false;
+	sampling_ratio = 1.0;
 }
 
 bundle_base::~bundle_base()
@@ -43,6 +44,7 @@ int bundle_base::add_hit(const hit &ht)
 
 	// set tid
 	if(tid == -1) tid = ht.tid;
+	if(chrm == "") chrm = ht.chrm;
 	assert(tid == ht.tid);
 
 	// set strand
@@ -119,6 +121,39 @@ int bundle_base::buildbase()
 	return 0;
 }
 
+// keep about n of the hits, chosen by qname so that mates are kept or dropped together;
+// each locus keeps the same fraction, so relative coverage is preserved;
+// the bundle is assembled at the sampled depth, its transcripts are scaled back by the assembler
+int bundle_base::downsample(int n)
+{
+	if(n <= 0 || hits.size() <= n) return 0;
+
+	sampling_ratio = 1.0 * n / hits.size();
+	uint32_t t = (uint32_t)(sampling_ratio * UINT32_MAX);
+
+	int k = 0;
+	is_allelic = false;
+	lpos = 1 << 30;
+	rpos = 0;
+	for(int i = 0; i < hits.size(); i++)
+	{
+		const hit &ht = hits[i];
+		uint32_t x = (uint32_t)(ht.qhash * 2654435761u);
+		if(x > t) continue;
+		if(ht.has_variant()) is_allelic = true;
+
+		// boundaries of the kept hits, as in add_hit
+		if(ht.pos < lpos) lpos = ht.pos;
+		if(ht.rpos > rpos) rpos = ht.rpos;
+		if(ht.mpos > ht.rpos && ht.mpos <= ht.rpos + 100000 && ht.mpos > rpos) rpos = ht.mpos;
+
+		if(k != i) hits[k] = hits[i];
+		k++;
+	}
+	hits.erase(hits.begin() + k, hits.end());
+	return 0;
+}
+
 bool bundle_base::overlap(const hit &ht) const
 {
 	if(mmap.find(ROI(ht.pos, ht.pos + 1)) != mmap.end()) return true;
@@ -134,6 +169,7 @@ int bundle_base::clear()
 	lpos = 1 << 30;
 	rpos = 0;
 	strand = '.';
+	sampling_ratio = 1.0;
 	apos_count.clear();
 	hits.clear();
 	mmap.clear();
@@ -33,12 +33,14 @@ public:
 	int32_t lpos;					// the leftmost boundary on reference
 	int32_t rpos;					// the rightmost boundary on reference
 	char strand;					// strandness
+	double sampling_ratio;			// fraction of hits kept by downsample()
 	vector<hit> hits;				// hits
 	split_interval_map mmap;		// matched interval map, built from hit.itv_align
 	split_interval_map imap;		// indel interval map
 
 public:
 	int buildbase();
+	int downsample(int n);
 	int add_hit(const hit &ht);
 	bool overlap(const hit &ht) const;
 	int clear();
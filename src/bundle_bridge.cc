@@ -11,6 +11,7 @@ See LICENSE for licensing.
 #include <map>
 #include <iomanip>
 #include <fstream>
+#include <thread>
 
 #include "bundle_bridge.h"
 #include "region.h"
@@ -18,9 +19,20 @@ See LICENSE for licensing.
 #include "util.h"
 #include "undirected_graph.h"
 #include "bridger.h"
+#include "run_stats.h"
 
-bundle_bridge::bundle_bridge(bundle_base &b)
-	: bb(b)
+static uint64_t first_key(const pair<int64_t, int> &x)
+{
+	return x.first;
+}
+
+static uint64_t second_key(const pair<int64_t, int> &x)
+{
+	return x.second;
+}
+
+bundle_bridge::bundle_bridge(bundle_base &b, const run_config &r)
+	: bb(b), rc(r)
 {
 }
 
@@ -29,6 +41,7 @@ bundle_bridge::~bundle_bridge()
 
 int bundle_bridge::build()
 {
+	stage_timer st(STAGE_BUNDLE_BRIDGE);
 	build_junctions();
 	extend_junctions();
 	build_regions();
@@ -39,11 +52,26 @@ int bundle_bridge::build()
 
 	if (verbose >= 3) print(1);
 
-	bridger bdg1(this, ALLELE1); 		// build w. ale1 & non-spec fragments, bridge al1 fragments only
-	bdg1.bridge();
+	// non-spec fragments are read but never bridged by bdg1 and bdg2, count their path nodes once
+	map<vector<int>, int> jshared;
+	bridger bdg0(this, UNPHASED);
+	bdg0.build_shared_path_nodes(jshared);
 
-	bridger bdg2(this, ALLELE2); 		// build w. ale2 & non-spec fragments, bridge al2 fragments only
-	bdg2.bridge();
+	bridger bdg1(this, ALLELE1, &jshared); 		// build w. ale1 & non-spec fragments, bridge al1 fragments only
+	bridger bdg2(this, ALLELE2, &jshared); 		// build w. ale2 & non-spec fragments, bridge al2 fragments only
+
+	// bdg1 and bdg2 write to disjoint fragments (and hits); bridge allele2 in its own thread
+	if(num_threads >= 2)
+	{
+		stage_thread t2(&bridger::bridge, &bdg2);
+		bdg1.bridge();
+		t2.join();
+	}
+	else
+	{
+		bdg1.bridge();
+		bdg2.bridge();
+	}
 
 	bridger bdg3(this, UNPHASED); 		// build w. all fragments, 			   bridge non-spec fragments only
 	bdg3.bridge();
@@ -51,64 +79,43 @@ int bundle_bridge::build()
 	return 0;
 }
 
+// splice positions of all hits are sorted once; each run is a junction, with strand voted in the same pass
 int bundle_bridge::build_junctions()
 {
 	junctions.clear();
-	map< as_pos, vector<int> > m;
+	vector< pair<int64_t, int> > v;		// (splice position, xs of hit)
 	for(int i = 0; i < bb.hits.size(); i++)
 	{
-		vector<as_pos> v = bb.hits[i].spos;
-		if(v.size() == 0) continue;
-
-		for(int k = 0; k < v.size(); k++)
+		const vector<as_pos> &sp = bb.hits[i].spos;
+		for(int k = 0; k < sp.size(); k++)
 		{
-			as_pos p = v[k];
-
-			if(m.find(p) == m.end())
-			{
-				vector<int> hv;
-				hv.push_back(i);
-				m.insert(pair< as_pos, vector<int> >(p, hv));
-			}
-			else
-			{
-				m[p].push_back(i);
-			}
+			assert(sp[k].ale == "$");
+			v.push_back(pair<int64_t, int>(sp[k].p64, bb.hits[i].xs));
 		}
 	}
+	radix_sort(v, first_key);
 
-	map< as_pos, vector<int> >::iterator it;
-	for(it = m.begin(); it != m.end(); it++)
+	for(int i = 0, j = 0; i < v.size(); i = j)
 	{
-		vector<int> &v = it->second;
-		if(v.size() < min_splice_boundary_hits) continue;
-
-		as_pos32 p1 = high32(it->first);
-		as_pos32 p2 = low32(it->first);
-
 		int s0 = 0;
 		int s1 = 0;
 		int s2 = 0;
-		int nm = 0;
-		for(int k = 0; k < v.size(); k++)
+		for(j = i; j < v.size() && v[j].first == v[i].first; j++)
 		{
-			hit &h = bb.hits[v[k]];
-			nm += h.nm;
-			if(h.xs == '.') s0++;
-			if(h.xs == '+') s1++;
-			if(h.xs == '-') s2++;
+			if(v[j].second == '.') s0++;
+			if(v[j].second == '+') s1++;
+			if(v[j].second == '-') s2++;
 		}
+		if(j - i < min_splice_boundary_hits) continue;
 
-		//printf("junction: %s:%d-%d (%d, %d, %d) %d\n", bb.chrm.c_str(), p1, p2, s0, s1, s2, s1 < s2 ? s1 : s2);
+		//printf("junction: %s:%d-%d (%d, %d, %d) %d\n", bb.chrm.c_str(), high32(v[i].first), low32(v[i].first), s0, s1, s2, s1 < s2 ? s1 : s2);
 
-		junction jc(it->first, v.size());
-		// jc.nm = nm;
+		junction jc(as_pos(v[i].first, "$"), j - i);
 		if(s1 == 0 && s2 == 0) jc.strand = '.';
 		else if(s1 >= 1 && s2 >= 1) jc.strand = '.';
 		else if(s1 > s2) jc.strand = '+';
 		else jc.strand = '-';
 		junctions.push_back(jc);
-		
 	}
 	sort(junctions.begin(), junctions.end());
 	
@@ -180,85 +187,110 @@ int bundle_bridge::build_regions()
 	/*
 		integral positions of splice-sites are identified based on h.spos.
 		....................  pseudo-splice sites ...............  h.apos.
-		Splice types of such positions are stored in `pos_splicetypes`.
+		Splice types of such positions are collected in `ptypes`, sorted and or'ed per position.
 		ALLELIC_LEFT_SPLICE is starting position of a variant (inclusive)
 		ALLELIC_RIGHT_SPLICE is ending position of a variant (exclusive)
-		set<splice_types> is converted to int constant by `splicetype_set_to_int`
 	*/
 	
-	map<int, set<int> > pos_splicetypes;  // < position_int, {splice_types} >
+	vector< pair<int64_t, int> > ptypes;  // < position, splice_type >
 
-	// add non-allelic pos to pos_splicetypes
-	pos_splicetypes.insert({bb.lpos, {START_BOUNDARY}});
-	pos_splicetypes.insert({bb.rpos, {END_BOUNDARY}});
+	// add non-allelic pos
+	ptypes.push_back(pair<int64_t, int>(bb.lpos, START_BOUNDARY));
+	ptypes.push_back(pair<int64_t, int>(bb.rpos, END_BOUNDARY));
 	for(int i = 0; i < junctions.size(); i++)
 	{
 		junction &jc = junctions[i];
-		int32_t l = jc.lpos.p32;
-		int32_t r = jc.rpos.p32;
-		pos_splicetypes[l].insert(LEFT_SPLICE);
-		pos_splicetypes[r].insert(RIGHT_SPLICE);
+		ptypes.push_back(pair<int64_t, int>(jc.lpos.p32, LEFT_SPLICE));
+		ptypes.push_back(pair<int64_t, int>(jc.rpos.p32, RIGHT_SPLICE));
 	}
 	
-	map<pair<int, int>, map<string, int> > poses_seqs;  // < (pos, pos), (allele_seq, count) >
+	// allelic sites: < pack(pos, pos), rank of allele_seq >, sorted by both and counted per run
+	map<string, int> aid;
+	vector< pair<int64_t, int> > psites;
 	for (const hit& h: bb.hits)
 	{
 		for (const as_pos& p: h.apos)
 		{
-			pair<int, int> p_int {high32(p), low32(p)};
-			poses_seqs[p_int][p.ale] += 1;
+			map<string, int>::iterator it = aid.find(p.ale);
+			if(it == aid.end()) 
+			{
+				it = aid.insert(pair<string, int>(p.ale, aid.size())).first;
+			}
+			psites.push_back(pair<int64_t, int>(p.p64, it->second));
+		}
+	}
+
+	// ranks follow the order of allele seqs so that sites are sorted as in map< pair<int, int>, map<string, int> >
+	vector<int> rank(aid.size());
+	vector<string> ranked;
+	for(map<string, int>::iterator it = aid.begin(); it != aid.end(); it++)
+	{
+		rank[it->second] = ranked.size();
+		ranked.push_back(it->first);
+	}
+	for(int i = 0; i < psites.size(); i++) psites[i].second = rank[psites[i].second];
+
+	radix_sort(psites, second_key);
+	radix_sort(psites, first_key);
+
+	vector<int64_t> sites;										// distinct pack(pos, pos) of variants
+	vector< vector< pair<string, int> > > seqs;				// (allele_seq, count) of each site
+	for(int i = 0, j = 0; i < psites.size(); i = j)
+	{
+		for(j = i; j < psites.size() && psites[j] == psites[i]; j++);
+		if(sites.size() == 0 || sites.back() != psites[i].first)
+		{
+			sites.push_back(psites[i].first);
+			seqs.resize(seqs.size() + 1);
+			ptypes.push_back(pair<int64_t, int>(high32(psites[i].first), ALLELIC_LEFT_SPLICE));
+			ptypes.push_back(pair<int64_t, int>(low32(psites[i].first), ALLELIC_RIGHT_SPLICE));
 		}
+		seqs.back().push_back(pair<string, int>(ranked[psites[i].second], j - i));
 	}
 
-	// add allelic pos (int) to pos_splicetypes
-	for (auto&& a: poses_seqs)
+	radix_sort(ptypes, first_key);
+	vector< pair<int32_t, int> > bounds;		// (position, or'ed splice types), ascending
+	for(int i = 0, j = 0; i < ptypes.size(); i = j)
 	{
-		auto poses = a.first;
-		int32_t l = poses.first;
-		int32_t r = poses.second;
-		pos_splicetypes[l].insert(ALLELIC_LEFT_SPLICE);
-		pos_splicetypes[r].insert(ALLELIC_RIGHT_SPLICE);
+		int t = 0;
+		for(j = i; j < ptypes.size() && ptypes[j].first == ptypes[i].first; j++) t |= ptypes[j].second;
+		bounds.push_back(pair<int32_t, int>(ptypes[i].first, t));
 	}
 
 	if (verbose >= 3 && print_bundle_bridge)
 	{
 		cout << "bundle_bridge build regions" << endl;
-		for (auto && p: pos_splicetypes)
+		for (auto && p: bounds)
 		{
-			cout << "pos_splicetypes " << p.first << ": {" ;
-			for (auto && ii : p.second) cout << ii << ", ";
-			cout << "}" << endl;
+			cout << "pos_splicetypes " << p.first << ": " << p.second << endl;
 		}
-		for(auto && p: poses_seqs)
+		for(int i = 0; i < sites.size(); i++)
 		{
-			cout << "poses_seqs (" << p.first.first << ", " << p.first.second << "): {";
-			for (auto && ii: p.second) cout << ii.first << " count="<< ii.second << ", ";
+			cout << "poses_seqs (" << high32(sites[i]) << ", " << low32(sites[i]) << "): {";
+			for (auto && ii: seqs[i]) cout << ii.first << " count="<< ii.second << ", ";
 			cout << "}" << endl;
 		}
 	}
 
+	// one linear merge of boundaries and allelic sites
 	regions.clear();
-	auto i1 = pos_splicetypes.begin();
-	auto i2 = poses_seqs.begin();
-	while (i1 != pos_splicetypes.end() && i2 != poses_seqs.end())
+	int i1 = 0;
+	int i2 = 0;
+	while (i1 + 1 < bounds.size() && i2 < sites.size())
 	{
-		int32_t l1 = i1->first;
-		int32_t r1 = std::next(i1, 1)->first;
-		int32_t l2 = i2->first.first;
-		int32_t r2 = i2->first.second;
-		auto&& ltypes = i1->second;
-		auto&& rtypes = std::next(i1)->second;
+		int32_t l1 = bounds[i1].first;
+		int32_t r1 = bounds[i1 + 1].first;
+		int32_t l2 = high32(sites[i2]);
+		int32_t r2 = low32(sites[i2]);
+		int ltype = bounds[i1].second;
+		int rtype = bounds[i1 + 1].second;
 
 		assert(l2 >= l1);
 
 		if (l2 >= r1) // non-AS region
 		{
-			as_pos32 l, r;
-			int ltype = 0, rtype = 0;
-			l = l1;
-			r = r1;
-			ltype = splicetype_set_to_int(ltypes);
-			rtype = splicetype_set_to_int(rtypes);
+			as_pos32 l = l1;
+			as_pos32 r = r1;
 			i1 ++;
 			region rr(l, r, ltype, rtype, UNPHASED);
 			evaluate_rectangle(bb.mmap, l, r, rr.ave, rr.dev, rr.max);
@@ -266,19 +298,15 @@ int bundle_bridge::build_regions()
 		}
 		else  // AS region, build all variants at same position
 		{
-			as_pos32 l, r;
-			int ltype = 0, rtype = 0;
 			assert (l1 == l2);
 			assert (r1 == r2);
-			for (auto&& aa: i2->second)
+			for (auto&& aa: seqs[i2])
 			{
 				string a = aa.first;
 				int c = aa.second;
-				l = as_pos32(l2, a);
-				r = as_pos32(r2, a);
-				ltype = splicetype_set_to_int(ltypes);
-				rtype = splicetype_set_to_int(rtypes);
-				genotype gt = asp.get_genotype(bb.chrm, l2, a);
+				as_pos32 l = as_pos32(l2, a);
+				as_pos32 r = as_pos32(r2, a);
+				genotype gt = (rc.vcf == NULL) ? UNPHASED : rc.vcf->get_genotype(bb.chrm, l2, a);
 				region rr(l, r, ltype, rtype, gt);
 				rr.assign_as_cov(c, 0.01, c); 
 				regions.push_back(rr);
@@ -287,21 +315,13 @@ int bundle_bridge::build_regions()
 			i1 ++;
 		}
 	}
-	assert (i2 == poses_seqs.end());
-	while (i1 != prev(pos_splicetypes.end()) )  // remaining non-AS region 
-	{
-		int32_t l1 = i1->first;
-		int32_t r1 = std::next(i1)->first;
-		auto&& ltypes = i1->second;
-		auto&& rtypes = std::next(i1)->second;
-
-		as_pos32 l, r;
-		int ltype, rtype;
-		
-		l = l1;
-		r = r1;
-		ltype = splicetype_set_to_int(ltypes);
-		rtype = splicetype_set_to_int(rtypes);
+	assert (i2 == sites.size());
+	while (i1 + 1 < bounds.size())  // remaining non-AS region 
+	{
+		as_pos32 l = bounds[i1].first;
+		as_pos32 r = bounds[i1 + 1].first;
+		int ltype = bounds[i1].second;
+		int rtype = bounds[i1 + 1].second;
 		i1 ++;
 		region rr(l, r, ltype, rtype, UNPHASED);
 		evaluate_rectangle(bb.mmap, l, r, rr.ave, rr.dev, rr.max);
@@ -331,63 +351,43 @@ int bundle_bridge::build_regions()
 	return 0;
 }
 
-
-int bundle_bridge::splicetype_set_to_int(set<int>& s)
+int bundle_bridge::build_region_bounds()
 {
-	int ss = 0;
-	for (int i: s)
+	lbounds.resize(regions.size());
+	rbounds.resize(regions.size());
+	for(int k = 0; k < regions.size(); k++)
 	{
-		ss += i;
+		lbounds[k] = regions[k].lpos.p32;
+		rbounds[k] = regions[k].rpos.p32;
 	}
-	return ss;
-}
-
 
-int bundle_bridge::align_hits_transcripts()
-{
-	map<as_pos32, int> m1;
-	map<as_pos32, int> m2;
-	for(int k = 0; k < regions.size(); k++)
-	{
-		m1.insert(pair<as_pos32, int>(regions[k].lpos, k));	
-		m2.insert(pair<as_pos32, int>(regions[k].rpos, k));	
-	}	
-	
 	if (DEBUG_MODE_ON)
 	{
-		assert(m1.size() == m2.size());
-		auto it1 = m1.begin();
-		auto it2 = m2.begin();
-		if (verbose >= 3 && print_bundle_bridge) cout << "bundle_bridge::align_hits_transcripts() m1/m2 size = " << m1.size() << endl;
-		for (int a = 0; a < m1.size(); a++)
+		if (verbose >= 3 && print_bundle_bridge) cout << "bundle_bridge::build_region_bounds() size = " << regions.size() << endl;
+		for(int k = 0; k < regions.size(); k++)
 		{
-			auto i = *it1;
-			auto j = *it2;
-			as_pos32 pp = i.first;
-			as_pos32 cc = i.second;
-			as_pos32 qq = j.first;
-			as_pos32 dd = j.second;
 			if (verbose >= 3 && print_bundle_bridge)  
 			{
-				cout << "bundle_bridge::align_hits_transcripts() m1/m2(region.l/rpos, idx) = " << pp.aspos32string() << " " ;
-				cout << qq.aspos32string() << " " << cc << endl;	
+				cout << "bundle_bridge::build_region_bounds() (region.l/rpos, idx) = " << regions[k].lpos.aspos32string() << " " ;
+				cout << regions[k].rpos.aspos32string() << " " << k << endl;	
 			}
-			assert(cc == dd);
-			it1 = next(it1, 1);
-			it2 = next(it2, 1);	
+			if(k == 0) continue;
+			assert(lbounds[k - 1] <= lbounds[k]);
+			assert(rbounds[k - 1] <= rbounds[k]);
 		}
 	}
+	return 0;
+}
 
-	for(int i = 0; i < bb.hits.size(); i++)
-	{
-		align_hit(m1, m2, bb.hits[i], bb.hits[i].vlist);
-		bb.hits[i].vlist = encode_vlist(bb.hits[i].vlist);
-	}
+int bundle_bridge::align_hits_transcripts()
+{
+	build_region_bounds();
+	align_hits();
 
 	ref_phase.resize(ref_trsts.size());
 	for(int i = 0; i < ref_trsts.size(); i++)
 	{
-		align_transcript(m1, ref_trsts[i], ref_phase[i]);
+		align_transcript(ref_trsts[i], ref_phase[i]);
 	}
 
 	/*if (verbose >= 3 && DEBUG_MODE_ON)
@@ -405,36 +405,53 @@ int bundle_bridge::align_hits_transcripts()
 	return 0;
 }
 
-int bundle_bridge::align_hit(const map<as_pos32, int> &m1, const map<as_pos32, int> &m2, const hit &h, vector<int> &vv)
+// hits come sorted by position, so the region of each hit start is found by
+// advancing a cursor over rbounds; lookups within a hit continue from there
+int bundle_bridge::align_hits()
+{
+	int k0 = 0;
+	int32_t p0 = INT32_MIN;
+	for(int i = 0; i < bb.hits.size(); i++)
+	{
+		hit &h = bb.hits[i];
+		int32_t p = h.itv_align.size() > 0 ? high32(h.itv_align.front()).p32 : p0;
+		if(p < p0) k0 = 0;
+		p0 = p;
+		k0 = lower_bound_index(rbounds, k0, (int)rbounds.size(), p0 + 1);
+		if(k0 >= regions.size()) k0 = 0;
+
+		align_hit(h, k0, h.vlist);
+		h.vlist = encode_vlist(h.vlist);
+	}
+	return 0;
+}
+
+// k0 must not exceed the index of the first region the hit overlaps
+int bundle_bridge::align_hit(const hit &h, int k0, vector<int> &vv)
 {
 	vv.clear();
 	vector<as_pos> v;
 	h.get_aligned_intervals(v);
 	if(v.size() == 0 && !h.has_variant() ) return 0;
-	assert(m1.size() == m2.size());
 
 	vector<PI> sp;
 	sp.resize(v.size());
 
-	as_pos32 p1 = high32(v.front());
-	as_pos32 p2 = low32(v.back());
-
-	sp[0].first = locate_region_left(m1, p1);
-	for(int k = 1; k < v.size(); k++)
-	{
-		p1 = high32(v[k]);
-		auto it = m1.find(p1);
-		assert(it != m1.end());
-		sp[k].first = it->second;
-	}
-
-	sp[sp.size() - 1].second = locate_region_right(m2, p2);
-	for(int k = 0; k < v.size() - 1; k++)
+	int k = k0;
+	for(int i = 0; i < v.size(); i++)
 	{
-		p2 = low32(v[k]);
-		auto it = m2.find(p2);
-		assert(it != m2.end());
-		sp[k].second = it->second; 
+		as_pos32 p1 = high32(v[i]);
+		as_pos32 p2 = low32(v[i]);
+
+		if(i == 0) sp[i].first = locate_region_left(p1, k);
+		else sp[i].first = locate_lbound(p1, k);
+		assert(sp[i].first >= 0);
+		k = sp[i].first;
+
+		if(i == v.size() - 1) sp[i].second = locate_region_right(p2, k);
+		else sp[i].second = locate_rbound(p2, k);
+		assert(sp[i].second >= 0);
+		k = sp[i].second;
 	}
 
 	// if(DEBUG_MODE_ON && print_hit) h.print();
@@ -455,7 +472,7 @@ int bundle_bridge::align_hit(const map<as_pos32, int> &m1, const map<as_pos32, i
 	return 0;
 }
 
-int bundle_bridge::align_transcript(const map<as_pos32, int> &m, const transcript &t, vector<int> &vv)
+int bundle_bridge::align_transcript(const transcript &t, vector<int> &vv)
 {
 	throw runtime_error("bundle_bridge::align_transcript() not used & not implemented");
 	vv.clear();
@@ -491,18 +508,17 @@ int bundle_bridge::align_transcript(const map<as_pos32, int> &m, const transcrip
 	for(int k = k1 + 1; k <= k2; k++)
 	{
 		p1 = t.exons[k].first;
-		map<as_pos32, int>::const_iterator it = m.find(p1);
-		assert(it != m.end());
-		sp[k].first = it->second;
+		sp[k].first = locate_lbound(p1);
+		assert(sp[k].first >= 0);
 	}
 
 	sp[k2].second = locate_region(p2 - 1);
 	for(int k = k1; k < k2; k++)
 	{
 		p2 = t.exons[k].second;
-		map<as_pos32, int>::const_iterator it = m.find(p2);
-		assert(it != m.end());
-		sp[k].second = it->second - 1; 
+		sp[k].second = locate_lbound(p2);
+		assert(sp[k].second >= 0);
+		sp[k].second = sp[k].second - 1; 
 	}
 
 	for(int k = k1; k <= k2; k++)
@@ -531,50 +547,49 @@ int bundle_bridge::index_references()
 	return 0;
 }
 
-int bundle_bridge::locate_region_left(const map<as_pos32, int> &m, as_pos32 x)
+// region whose lpos is exactly x; AS regions sharing the position are told apart by allele
+int bundle_bridge::locate_lbound(as_pos32 x, int k0)
 {
-	if(regions.size() == 0) return -1;
-
-	if (x.ale != "$") 
+	for(int k = lower_bound_index(lbounds, k0, (int)lbounds.size(), x.p32); k < lbounds.size() && lbounds[k] == x.p32; k++)
 	{
-		auto it = m.find(x);
-		assert(it != m.end());
-		return it->second;
+		if(regions[k].lpos.ale == x.ale) return k;
 	}
-
-	return locate_region(x);
+	return -1;
 }
 
-int bundle_bridge::locate_region_right(const map<as_pos32, int> &m, as_pos32 x)
+// region whose rpos is exactly x; AS regions sharing the position are told apart by allele
+int bundle_bridge::locate_rbound(as_pos32 x, int k0)
 {
-	if(regions.size() == 0) return -1;
-
-	if (x.ale != "$") 
+	for(int k = lower_bound_index(rbounds, k0, (int)rbounds.size(), x.p32); k < rbounds.size() && rbounds[k] == x.p32; k++)
 	{
-		auto it = m.find(x);
-		assert(it != m.end());
-		return it->second;
+		if(regions[k].rpos.ale == x.ale) return k;
 	}
+	return -1;
+}
+
+int bundle_bridge::locate_region_left(as_pos32 x, int k0)
+{
+	if(regions.size() == 0) return -1;
+	if (x.ale != "$") return locate_lbound(x, k0);
+	return locate_region(x, k0);
+}
 
-	return locate_region(x-1);
+int bundle_bridge::locate_region_right(as_pos32 x, int k0)
+{
+	if(regions.size() == 0) return -1;
+	if (x.ale != "$") return locate_rbound(x, k0);
+	return locate_region(x - 1, k0);
 }
 
 // find region of pos (non-splice/as pos)
-int bundle_bridge::locate_region(as_pos32 x)
+int bundle_bridge::locate_region(as_pos32 x, int k0)
 {
 	if(regions.size() == 0) return -1;
 	assert (x.ale == "$");
-	int k1 = 0;
-	int k2 = regions.size();
-	while(k1 < k2)
-	{
-		int m = (k1 + k2) / 2;
-		region &r = regions[m];
-		if(x.rightsameto(r.lpos) && x.leftto(r.rpos)) return m;
-		else if(x < r.lpos) k2 = m;
-		else k1 = m;
-	}
-	return -1;
+	int k = lower_bound_index(rbounds, k0, (int)rbounds.size(), x.p32 + 1);
+	if(k >= regions.size()) return -1;
+	if(lbounds[k] > x.p32) return -1;
+	return k;
 }
 
 int bundle_bridge::build_fragments()
@@ -960,27 +975,29 @@ vector<int32_t> bundle_bridge::build_accumulate_length(const vector<int> &v)
 	return acc;
 }
 
-vector<as_pos32> bundle_bridge::get_aligned_intervals(fragment &fr)
+// vv is cleared and filled with [h1->pos, splices..., h2->rpos]; left empty if not well aligned
+int bundle_bridge::get_aligned_intervals(fragment &fr, vector<as_pos32> &vv)
 {
-	vector<as_pos32> vv;
-	if(fr.paths.size() != 1) return vv;
+	vv.clear();
+	if(fr.paths.size() != 1) return 0;
 	assert(fr.paths[0].type == 1 || fr.paths[0].type == 2);
 
-	vector<as_pos32> v = get_splices(fr);
-	if(v.size() >= 1 && fr.h1->pos >= v.front()) return vv;
-	if(v.size() >= 1 && fr.h2->rpos <= v.back()) return vv;
+	vv.push_back(fr.h1->pos);
+	get_splices(fr, vv);
+	if(vv.size() >= 2 && fr.h1->pos >= vv[1]) vv.clear();
+	if(vv.size() >= 2 && fr.h2->rpos <= vv.back()) vv.clear();
+	if(vv.size() == 0) return 0;
 
-	//// for (auto i : v) cout << "get splices" << i.aspos32string() << endl;	
+	//// for (auto i : vv) cout << "get splices" << i.aspos32string() << endl;	
 	
-	v.insert(v.begin(), fr.h1->pos);
-	v.push_back(fr.h2->rpos);
-	return v;
+	vv.push_back(fr.h2->rpos);
+	return 0;
 }
 
-vector<as_pos32> bundle_bridge::get_splices(fragment &fr)
+// splices of fr are appended to vv
+int bundle_bridge::get_splices(fragment &fr, vector<as_pos32> &vv)
 {
-	vector<as_pos32> vv;
-	if(fr.paths.size() != 1) return vv;
+	if(fr.paths.size() != 1) return 0;
 	assert(fr.paths[0].type == 1 || fr.paths[0].type == 2);
 
 	vector<int> v = decode_vlist(fr.paths[0].v);
@@ -988,7 +1005,7 @@ vector<as_pos32> bundle_bridge::get_splices(fragment &fr)
 	//// for (int i = 0; i < v.size() - 1; i++) 
 	//// 	cout << "get splices2 " << regions[v[i + 0]].rpos.aspos32string() << "--" << regions[v[i + 1]].lpos.aspos32string() << endl;
 
-	if(v.size() <= 0) return vv;
+	if(v.size() <= 0) return 0;
 
 	for(int i = 0; i < v.size() - 1; i++)
 	{
@@ -999,7 +1016,7 @@ vector<as_pos32> bundle_bridge::get_splices(fragment &fr)
 		vv.push_back(pp);
 		vv.push_back(qq);
 	}
-	return vv;
+	return 0;
 }
 
 vector<int> bundle_bridge::get_splices_region_index(fragment &fr)
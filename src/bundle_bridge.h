@@ -14,22 +14,26 @@ See LICENSE for licensing.
 #include "region.h"
 #include "fragment.h"
 #include "transcript.h"
+#include "run_context.h"
 
 using namespace std;
 
 class bundle_bridge
 {
 public:
-	bundle_bridge(bundle_base &bb);
+	bundle_bridge(bundle_base &bb, const run_config &rc);
 	virtual ~bundle_bridge();
 
 public:
 	bundle_base &bb;							// input bundle base
+	const run_config &rc;						// variants and insert sizes
 	set<string> breads;							// bridged reads
 	vector<fragment> fragments;					// to-be-filled fragments
 	vector<junction> junctions;					// splice junctions
 	map<as_pos, vector<int> > allelic_itv; 		// allelic aspos intervals and hits containing them
 	vector<region> regions;						// pexons
+	vector<int32_t> lbounds;					// lpos of each region, sorted; AS regions share a position
+	vector<int32_t> rbounds;					// rpos of each region, sorted; AS regions share a position
 	vector<transcript> ref_trsts;				// overlaped genes in reference						// not used
 	vector< vector<int> > ref_phase;			// phasing paths for ref transcripts				// not used
 	vector< vector<PI> > ref_index;				// the set of trsts that contain each region		// not used
@@ -41,13 +45,12 @@ public:
 	int print(int index);
 	int32_t compute_aligned_length(int32_t k1l, int32_t k2r, const vector<int>& v);
 	vector<int32_t> build_accumulate_length(const vector<int> &v);
-	vector<as_pos32> get_aligned_intervals(fragment &fr);
-	vector<as_pos32> get_splices(fragment &fr);
+	int get_aligned_intervals(fragment &fr, vector<as_pos32> &vv);
+	int get_splices(fragment &fr, vector<as_pos32> &vv);
 	vector<int> get_aligned_intervals_region_index(fragment &fr);
 	vector<int> get_splices_region_index(fragment &fr);
 
 private:
-	int splicetype_set_to_int(set<int>&);
 
 public:
 	int build_junctions();
@@ -57,13 +60,17 @@ public:
 
 	int build_fragments();
 
+	int build_region_bounds();
 	int align_hits_transcripts();
-	int align_hit(const map<as_pos32, int> &m1, const map<as_pos32, int> &m2, const hit &h, vector<int> &v);
-	int align_transcript(const map<as_pos32, int> &m, const transcript &t, vector<int> &v);
+	int align_hits();
+	int align_hit(const hit &h, int k0, vector<int> &v);
+	int align_transcript(const transcript &t, vector<int> &v);
 	int index_references();
-	int locate_region_left(const map<as_pos32, int> &m, as_pos32 x);
-	int locate_region_right(const map<as_pos32, int> &m, as_pos32 x);
-	int locate_region(as_pos32 x);
+	int locate_lbound(as_pos32 x, int k0 = 0);
+	int locate_rbound(as_pos32 x, int k0 = 0);
+	int locate_region_left(as_pos32 x, int k0 = 0);
+	int locate_region_right(as_pos32 x, int k0 = 0);
+	int locate_region(as_pos32 x, int k0 = 0);
 };
 
 #endif
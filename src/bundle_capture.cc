@@ -0,0 +1,122 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "bundle_capture.h"
+#include "config.h"
+#include "util.h"
+
+static const string capture_magic = "ALTAICAP";
+static const int32_t capture_version = 1;
+
+int bundle_capture::write_header(ostream &fout, const run_config &rc)
+{
+	fout.write(capture_magic.c_str(), capture_magic.size());
+	write_binary(fout, capture_version);
+	write_binary(fout, (int32_t)(sizeof(bam1_core_t)));
+	write_binary(fout, rc.library_type);
+	write_binary(fout, rc.insertsize_ave);
+	write_binary(fout, rc.insertsize_std);
+	write_binary(fout, rc.insertsize_median);
+	write_binary(fout, rc.insertsize_low);
+	write_binary(fout, rc.insertsize_high);
+	return 0;
+}
+
+bool bundle_capture::read_header(istream &fin, run_config &rc)
+{
+	string magic(capture_magic.size(), ' ');
+	fin.read(&magic[0], magic.size());
+	if(fin.fail() || magic != capture_magic)
+	{
+		printf("not a bundle capture file\n");
+		return false;
+	}
+
+	int32_t version = 0;
+	int32_t core_size = 0;
+	read_binary(fin, version);
+	read_binary(fin, core_size);
+	if(version != capture_version || core_size != sizeof(bam1_core_t))
+	{
+		printf("bundle capture file of version %d (core size %d) is not supported\n", version, core_size);
+		return false;
+	}
+
+	read_binary(fin, rc.library_type);
+	read_binary(fin, rc.insertsize_ave);
+	read_binary(fin, rc.insertsize_std);
+	read_binary(fin, rc.insertsize_median);
+	read_binary(fin, rc.insertsize_low);
+	return read_binary(fin, rc.insertsize_high);
+}
+
+int bundle_capture::write(ostream &fout, const bundle_base &bb)
+{
+	write_binary(fout, bb.tid);
+	write_binary(fout, bb.chrm);
+	write_binary(fout, bb.lpos);
+	write_binary(fout, bb.rpos);
+	write_binary(fout, bb.strand);
+	write_binary(fout, bb.is_allelic);
+	write_binary(fout, bb.sampling_ratio);
+	write_binary(fout, (uint32_t)(bb.hits.size()));
+	for(int i = 0; i < bb.hits.size(); i++) bb.hits[i].write(fout);
+	return 0;
+}
+
+bool bundle_capture::read(istream &fin, bundle_base &bb)
+{
+	bb.clear();
+	if(read_binary(fin, bb.tid) == false) return false;
+	if(bb.tid < 0) return false;
+	read_binary(fin, bb.chrm);
+	read_binary(fin, bb.lpos);
+	read_binary(fin, bb.rpos);
+	read_binary(fin, bb.strand);
+	read_binary(fin, bb.is_allelic);
+	read_binary(fin, bb.sampling_ratio);
+
+	uint32_t n = 0;
+	if(read_binary(fin, n) == false) return false;
+	bb.hits.reserve(n);
+	for(int i = 0; i < n; i++) bb.hits.push_back(hit(fin));
+	return fin.good();
+}
+
+// marked by a negative tid, which is never captured
+int bundle_capture::write_footer(ostream &fout, double qlen, int qcnt)
+{
+	write_binary(fout, (int32_t)(-1));
+	write_binary(fout, qlen);
+	write_binary(fout, qcnt);
+	return 0;
+}
+
+// to be called once read() returned false
+bool bundle_capture::read_footer(istream &fin, double &qlen, int &qcnt)
+{
+	read_binary(fin, qlen);
+	return read_binary(fin, qcnt);
+}
+
+// chrm, chrm:lpos-rpos (1-based, inclusive)
+bool bundle_capture::parse_region(const string &s, string &chrm, int32_t &lpos, int32_t &rpos)
+{
+	size_t k = s.find(':');
+	chrm = s.substr(0, k);
+	lpos = 0;
+	rpos = 1 << 30;
+	if(k == string::npos) return true;
+
+	size_t d = s.find('-', k);
+	if(d == string::npos) return false;
+	lpos = atoi(s.substr(k + 1, d - k - 1).c_str()) - 1;
+	rpos = atoi(s.substr(d + 1).c_str());
+	return lpos >= 0 && lpos < rpos;
+}
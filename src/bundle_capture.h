@@ -0,0 +1,33 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __BUNDLE_CAPTURE_H__
+#define __BUNDLE_CAPTURE_H__
+
+#include <string>
+#include <iostream>
+
+#include "bundle_base.h"
+#include "run_context.h"
+
+using namespace std;
+
+// binary capture of bundles (hits with their features) for replaying the downstream stages;
+// a header with the preview parameters is followed by one record per bundle, taken before buildbase,
+// and a footer with the read counts used for RPKM
+class bundle_capture
+{
+public:
+	static int write_header(ostream &fout, const run_config &rc);
+	static bool read_header(istream &fin, run_config &rc);	// also restores library_type and insert sizes
+	static int write(ostream &fout, const bundle_base &bb);
+	static bool read(istream &fin, bundle_base &bb);	// false at the footer or the end of file
+	static int write_footer(ostream &fout, double qlen, int qcnt);
+	static bool read_footer(istream &fin, double &qlen, int &qcnt);
+	static bool parse_region(const string &s, string &chrm, int32_t &lpos, int32_t &rpos);
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <algorithm>
+
+#include "bundle_log.h"
+
+bundle_record::bundle_record()
+	: lpos(0), rpos(0), strand('.'), mode(0), index(0), hits(0), fragments(0), regions(0),
+	vertices0(0), edges0(0), vertices1(0), edges1(0), hyper_edges(0), subs(0),
+	t_prepare(0), t_build(0), t_assemble(0)
+{}
+
+double bundle_record::seconds() const
+{
+	return t_prepare + t_build + t_assemble;
+}
+
+// the slowest record is at the bottom of the heap
+static bool record_slower(const bundle_record &x, const bundle_record &y)
+{
+	return x.seconds() > y.seconds();
+}
+
+bundle_log::bundle_log()
+	: top_n(0)
+{}
+
+int bundle_log::add(const bundle_record &r, const splice_graph &gr)
+{
+	if(top_n > 0 && records.size() >= top_n && r.seconds() <= records.front().seconds()) return 0;
+
+	records.push_back(r);
+	bundle_record &x = records.back();
+	if(graph_prefix != "")
+	{
+		char buf[1024];
+		sprintf(buf, "%s.%s.%d.%d.%c.gene%d.mode%d.sgraph", graph_prefix.c_str(), x.chrm.c_str(), x.lpos, x.rpos, x.strand, x.index, x.mode);
+		x.graph_file = buf;
+		gr.write(x.graph_file);
+	}
+
+	if(top_n <= 0) return 0;
+
+	push_heap(records.begin(), records.end(), record_slower);
+	if(records.size() <= top_n) return 0;
+
+	pop_heap(records.begin(), records.end(), record_slower);
+	string f = records.back().graph_file;
+	records.pop_back();
+
+	// rounds of --replay repeat the same bundles, keep the file while a kept record refers to it
+	for(int i = 0; i < records.size() && f != ""; i++)
+	{
+		if(records[i].graph_file == f) f = "";
+	}
+	if(f != "") remove(f.c_str());
+	return 0;
+}
+
+int bundle_log::write(const string &file)
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if(f == NULL)
+	{
+		printf("open file %s error\n", file.c_str());
+		return 0;
+	}
+
+	if(top_n > 0) sort_heap(records.begin(), records.end(), record_slower);
+
+	fprintf(f, "chrm\tlpos\trpos\tstrand\tmode\tgene\thits\tfragments\tregions\tvertices0\tedges0\tvertices1\tedges1\thyper_edges\tsubs\t");
+	fprintf(f, "prepare_seconds\tbuild_seconds\tassemble_seconds\tseconds\tgraph_file\n");
+	for(int i = 0; i < records.size(); i++)
+	{
+		const bundle_record &r = records[i];
+		fprintf(f, "%s\t%d\t%d\t%c\t%d\tgene.%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t",
+				r.chrm.c_str(), r.lpos, r.rpos, r.strand, r.mode, r.index, r.hits, r.fragments, r.regions,
+				r.vertices0, r.edges0, r.vertices1, r.edges1, r.hyper_edges, r.subs);
+		fprintf(f, "%.6lf\t%.6lf\t%.6lf\t%.6lf\t%s\n", r.t_prepare, r.t_build, r.t_assemble, r.seconds(), r.graph_file == "" ? "." : r.graph_file.c_str());
+	}
+	fclose(f);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __BUNDLE_LOG_H__
+#define __BUNDLE_LOG_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "splice_graph.h"
+
+using namespace std;
+
+// shape and timing of one bundle assembled in one mode
+class bundle_record
+{
+public:
+	bundle_record();
+
+public:
+	string chrm;
+	int32_t lpos;
+	int32_t rpos;
+	char strand;
+	int mode;				// bundle_mode used to build the graph
+	int index;				// gene index, as in gene ids
+	int hits;
+	int fragments;
+	int regions;
+	int vertices0;			// vertices of the splice graph before revision
+	int edges0;				// edges of the splice graph before revision
+	int vertices1;			// vertices of the splice graph after revision
+	int edges1;				// edges of the splice graph after revision
+	int hyper_edges;		// phasing paths in the hyper set
+	int subs;				// subgraphs from super_graph
+	double t_prepare;		// bridging and mode-independent preparation, shared by both modes
+	double t_build;			// building and revising the splice graph
+	double t_assemble;		// super_graph, scallop and phaser
+	string graph_file;		// dumped splice graph, if any
+
+public:
+	double seconds() const;
+};
+
+/*
+**	bundle_log keeps all bundle_records, or only the top_n slowest of them when top_n > 0;
+**	if graph_prefix is not empty, the splice graph of each kept record is dumped with splice_graph::write
+**	and removed again once the record drops out of the top_n
+*/
+class bundle_log
+{
+public:
+	bundle_log();
+
+public:
+	int top_n;
+	string graph_prefix;
+
+public:
+	int add(const bundle_record &r, const splice_graph &gr);
+	int write(const string &file);
+
+private:
+	vector<bundle_record> records;		// min-heap on seconds() when top_n > 0
+};
+
+#endif
@@ -13,6 +13,7 @@ See LICENSE for licensing.
 #include "config.h"
 #include "vcf_data.h"
 #include "util.h"
+#include "htslib/faidx.h"
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -57,7 +58,7 @@ double min_bridging_score = 0.5;
 int max_num_path_nodes = 10000;
 int dp_solution_size = 10;
 int dp_stack_size = 5;
-bool use_overlap_scoring = false;
+bool use_overlap_scoring = true;
 int32_t max_clustering_flank = 30;
 int32_t flank_tiny_length = 10;
 double flank_tiny_ratio = 0.4;
@@ -93,6 +94,11 @@ int min_transcript_length_increase = 50;
 int min_exon_length = 20;
 int max_num_exons = 1000;
 
+// for huge bundles
+int max_num_bundle_hits = 0;
+long max_num_paths = 0;
+double max_bundle_seconds = 0;
+
 // for subsetsum and router
 int max_dp_table_size = 10000;
 int min_router_count = 1;
@@ -106,14 +112,25 @@ int simulation_max_edge_weight = 0;
 string algo = "Altai";
 string input_file;
 string fasta_input;
-faidx_t* fai;
-string fai_file;
+int fasta_line_length = 60;
 string ref_file;
 string ref_file1;
 string ref_file2;
 string vcf_file;
 string output_file;
 string output_file1 = "";
+string stats_json_file = "";
+bool output_bgzf = false;
+string bundle_log_file = "";
+int bundle_log_top = 0;
+bool bundle_log_graphs = false;
+string capture_file = "";
+string capture_region = "";
+double capture_min_seconds = 0;
+string replay_file = "";
+int replay_rounds = 1;
+string batch_file = "";
+int batch_jobs = 1;
 string chr_exclude;
 set<string> chrex;
 
@@ -121,13 +138,6 @@ set<string> chrex;
 bool mask_WASP = false;
 int min_num_reads_support_variant = 3;
 vcf_data asp;
-string vmap_chrm = "";
-map < string, map <int, map <string, genotype> > >     vcf_map;
-map < std::string, map <int, int > >                   vcf_map_len;
-map <int, map <string, genotype> >::iterator           vcf_map_it;
-map <int, int >::iterator                              vcf_map_len_it;
-map <int, map <string, genotype> >::iterator           vcf_map_end;
-map <int, int >::iterator                              vcf_map_len_end;
 double major_gt_threshold = 0.75;
 bool use_opposite_phasing = false;
 bool break_unphased_allelic_phasing = true;
@@ -141,6 +151,8 @@ string fixed_gene_name = "";
 int batch_bundle_size = 10;
 int verbose = 1;
 int assemble_duplicates = 10;
+int num_threads = 1;
+uint64_t random_seed = 0;
 string version = "v0.0.1";
 bool decompose_as_neighor = false;
 bool to_revise_splice_graph = true;
@@ -185,7 +197,11 @@ int parse_arguments(int argc, const char ** argv)
 		else if (string(argv[i]) == "-G")
 		{
 			fasta_input = string(argv[i + 1]);
-			fai = fai_load(fasta_input.c_str());
+			i++;
+		}
+		else if(string(argv[i]) == "--fasta_line_length")
+		{
+			fasta_line_length = atoi(argv[i + 1]);
 			i++;
 		}
 		else if(string(argv[i]) == "-f" || string(argv[i]) == "--transcript_fragments")
@@ -193,6 +209,64 @@ int parse_arguments(int argc, const char ** argv)
 			output_file1 = string(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--stats-json")
+		{
+			stats_json_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--output_bgzf")
+		{
+			output_bgzf = true;
+		}
+		else if(string(argv[i]) == "--bundle_log")
+		{
+			bundle_log_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--bundle_log_top")
+		{
+			bundle_log_top = atoi(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--bundle_log_graphs")
+		{
+			bundle_log_graphs = true;
+		}
+		else if(string(argv[i]) == "--capture")
+		{
+			capture_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--capture_region")
+		{
+			capture_region = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--capture_min_seconds")
+		{
+			capture_min_seconds = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--replay")
+		{
+			replay_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--replay_rounds")
+		{
+			replay_rounds = atoi(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--batch")
+		{
+			batch_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--batch_jobs")
+		{
+			batch_jobs = atoi(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "-r")
 		{
 			ref_file = string(argv[i + 1]);
@@ -376,6 +450,21 @@ int parse_arguments(int argc, const char ** argv)
 			max_num_exons = atoi(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--max_num_bundle_hits")
+		{
+			max_num_bundle_hits = atoi(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--max_num_paths")
+		{
+			max_num_paths = atol(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--max_bundle_seconds")
+		{
+			max_bundle_seconds = atof(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "--max_dp_table_size")
 		{
 			max_dp_table_size = atoi(argv[i + 1]);
@@ -454,6 +543,17 @@ int parse_arguments(int argc, const char ** argv)
 			assemble_duplicates = atoi(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--seed")
+		{
+			random_seed = strtoull(argv[i + 1], NULL, 10);
+			i++;
+		}
+		else if(string(argv[i]) == "--num_threads")
+		{
+			num_threads = atoi(argv[i + 1]);
+			if(num_threads < 1) num_threads = 1;
+			i++;
+		}
 		else if(string(argv[i]) == "--bundle_mode")
 		{
 			bundle_mode = atoi(argv[i + 1]);
@@ -474,6 +574,13 @@ int parse_arguments(int argc, const char ** argv)
 			min_bridging_score = atof(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--use_overlap_scoring")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") use_overlap_scoring = true;
+			else use_overlap_scoring = false;
+			i++;
+		}
 		else if(string(argv[i]) == "--dp_solution_size")
 		{
 			dp_solution_size = atof(argv[i + 1]);
@@ -482,6 +589,8 @@ int parse_arguments(int argc, const char ** argv)
 		else if(string(argv[i]) == "--dp_stack_size")
 		{
 			dp_stack_size = atof(argv[i + 1]);
+			if(dp_stack_size < 1) dp_stack_size = 1;
+			if(dp_stack_size > MAX_DP_STACK_SIZE) dp_stack_size = MAX_DP_STACK_SIZE;
 			i++;
 		}
 		else if(string(argv[i]) == "--max_clustering_flank")
@@ -663,12 +772,18 @@ int parse_arguments(int argc, const char ** argv)
 	}
 
 	// verify + process arguments
-	if(input_file == "")
+	if(input_file == "" && replay_file == "" && batch_file == "")
 	{
 		printf("error: input-file is missing.\n");
 		exit(0);
 	}
 
+	if(batch_file != "" && (input_file != "" || output_file != "" || output_file1 != "" || replay_file != "" || capture_file != "" || bundle_log_file != ""))
+	{
+		printf("error: -i, -o, -f, --replay, --capture and --bundle_log are per sample and cannot be used with --batch.\n");
+		exit(0);
+	}
+
 	if(vcf_file == "" && preview_only == false)
 	{
 		printf("error: vcf-file is missing.\n");
@@ -678,8 +793,6 @@ int parse_arguments(int argc, const char ** argv)
 	else
 	{
 		asp = vcf_data(vcf_file);
-		vcf_map = asp.vcf_pos_map;
-		vcf_map_len = asp.vcf_ale_len;
 		if(DEBUG_MODE_ON && print_vcf) 
 		{
 			asp.print();
@@ -688,12 +801,24 @@ int parse_arguments(int argc, const char ** argv)
 		}
 	}
 
-	if(output_file == "" && preview_only == false)
+	if(output_file == "" && batch_file == "" && preview_only == false)
 	{
 		printf("error: output-file is missing.\n");
 		exit(0);
 	}
 
+	// each worker loads its own index later; fail now rather than write empty fasta files
+	if(fasta_input != "")
+	{
+		faidx_t *fai = fai_load(fasta_input.c_str());
+		if(fai == NULL)
+		{
+			printf("error: cannot load or build the index of genome fasta %s.\n", fasta_input.c_str());
+			exit(1);
+		}
+		fai_destroy(fai);
+	}
+
 	return 0;
 }
 
@@ -737,8 +862,14 @@ int print_parameters()
 	printf("min_transcript_length_increase = %d\n", min_transcript_length_increase);
 	printf("max_num_exons = %d\n", max_num_exons);
 
+	// for huge bundles
+	printf("max_num_bundle_hits = %d\n", max_num_bundle_hits);
+	printf("max_num_paths = %ld\n", max_num_paths);
+	printf("max_bundle_seconds = %.2lf\n", max_bundle_seconds);
+
 	// for subsetsum and router
 	printf("max_dp_table_size = %d\n", max_dp_table_size);
+	printf("use_overlap_scoring = %c\n", use_overlap_scoring ? 'T' : 'F');
 	printf("min_router_count = %d\n", min_router_count);
 
 	// for simulation
@@ -754,6 +885,19 @@ int print_parameters()
 	printf("ref_file2 = %s\n", ref_file2.c_str());
 	printf("output_file = %s\n", output_file.c_str());
 	printf("output_file1 = %s\n", output_file1.c_str());
+	printf("stats_json_file = %s\n", stats_json_file.c_str());
+	printf("output_bgzf = %c\n", output_bgzf ? 'T' : 'F');
+	printf("fasta_line_length = %d\n", fasta_line_length);
+	printf("bundle_log_file = %s\n", bundle_log_file.c_str());
+	printf("bundle_log_top = %d\n", bundle_log_top);
+	printf("bundle_log_graphs = %c\n", bundle_log_graphs ? 'T' : 'F');
+	printf("capture_file = %s\n", capture_file.c_str());
+	printf("capture_region = %s\n", capture_region.c_str());
+	printf("capture_min_seconds = %.2lf\n", capture_min_seconds);
+	printf("replay_file = %s\n", replay_file.c_str());
+	printf("replay_rounds = %d\n", replay_rounds);
+	printf("batch_file = %s\n", batch_file.c_str());
+	printf("batch_jobs = %d\n", batch_jobs);
 
 	// for controling
 	printf("library_type = %d\n", library_type);
@@ -764,6 +908,8 @@ int print_parameters()
 	printf("uniquely_mapped_only = %c\n", uniquely_mapped_only ? 'T' : 'F');
 	printf("verbose = %d\n", verbose);
 	printf("batch_bundle_size = %d\n", batch_bundle_size);
+	printf("num_threads = %d\n", num_threads);
+	printf("random_seed = %lu\n", (unsigned long)(random_seed));
 
 	printf("\n");
 
@@ -818,8 +964,23 @@ int print_help()
 	printf(" %-42s  %s\n", "--preview",  "determine fragment-length-range and library-type and exit");
 	printf(" %-42s  %s\n", "--verbose <0, 1, 2>",  "0: quiet; 1: one line for each graph; 2: with details, default: 1");
 	printf(" %-42s  %s\n", "-f/--transcript_fragments <filename>",  "file to which the assembled non-full-length transcripts will be written to");
+	printf(" %-42s  %s\n", "--stats-json <filename>",  "file to which per-stage time, peak RSS (of the process while the stage runs) and allocation statistics will be written to");
+	printf(" %-42s  %s\n", "--fasta_line_length <integer>",  "bases per line of the fasta output (with -G), 0: one line per transcript, default: 60");
+	printf(" %-42s  %s\n", "--output_bgzf",  "write gtf and gvf files BGZF-compressed, as .gtf.gz and .gvf.gz");
+	printf(" %-42s  %s\n", "--bundle_log <filename>",  "file to which per-bundle graph sizes and stage times will be written to, as TSV");
+	printf(" %-42s  %s\n", "--bundle_log_top <integer>",  "keep only the slowest bundles in the bundle log, 0: keep all, default: 0");
+	printf(" %-42s  %s\n", "--bundle_log_graphs",  "also dump the splice graph of each logged bundle next to the bundle log");
+	printf(" %-42s  %s\n", "--capture <filename>",  "file to which bundles (hits with features) will be written to, for --replay");
+	printf(" %-42s  %s\n", "--capture_region <chr[:start-end]>",  "capture only bundles overlapping this region, default: all");
+	printf(" %-42s  %s\n", "--capture_min_seconds <float>",  "capture only bundles taking at least this long to assemble, default: 0");
+	printf(" %-42s  %s\n", "--replay <filename>",  "assemble the bundles of a capture file instead of -i, using the same -j");
+	printf(" %-42s  %s\n", "--replay_rounds <integer>",  "number of times the captured bundles are assembled in --replay, default: 1");
+	printf(" %-42s  %s\n", "--batch <filename>",  "assemble the samples of a manifest (lines of <bam-file> <output-prefix>) instead of -i and -o");
+	printf(" %-42s  %s\n", "--batch_jobs <integer>",  "number of samples assembled at the same time in --batch, default: 1");
 	printf(" %-42s  %s\n", "--library_type <first, second, unstranded>",  "library type of the sample, default: unstranded");
 	printf(" %-42s  %s\n", "--assemble_duplicates <integer>",  "the number of consensus runs of the decomposition, default: 10");
+	printf(" %-42s  %s\n", "--num_threads <integer>",  "the number of threads used to assemble and write alleles concurrently and to preview the samples of --batch, default: 1");
+	printf(" %-42s  %s\n", "--seed <integer>",  "seed of the random orderings in decomposition; output does not depend on --num_threads, default: 0");
 	printf(" %-42s  %s\n", "--min_transcript_coverage <float>",  "minimum coverage required for a multi-exon transcript, default: 1.5");
 //  printf(" %-42s  %s\n", "--min_transcript_coverage <float>",  "minimum coverage required for a multi-exon transcript, default: 1.01");
 	printf(" %-42s  %s\n", "--min_single_exon_coverage <float>",  "minimum coverage required for a single-exon transcript, default: 20");
@@ -830,6 +991,10 @@ int print_help()
 	printf(" %-42s  %s\n", "--max_num_cigar <integer>",  "ignore reads with CIGAR size larger than this value, default: 1000");
 	printf(" %-42s  %s\n", "--min_bundle_gap <integer>",  "minimum distances required to start a new bundle, default: 100");
 	printf(" %-42s  %s\n", "--min_num_hits_in_bundle <integer>",  "minimum number of reads required in a gene locus, default: 5");
+	printf(" %-42s  %s\n", "--max_num_bundle_hits <integer>",  "downsample reads of a gene locus with more reads than this value; it is assembled at the sampled depth and its transcript coverage scaled back, 0: no limit, default: 0");
+	printf(" %-42s  %s\n", "--max_num_paths <integer>",  "use greedy decomposition for graphs with more s-t paths than this value, 0: no limit, default: 0");
+	printf(" %-42s  %s\n", "--max_bundle_seconds <float>",  "use greedy decomposition once a gene locus runs longer than this, 0: no limit, default: 0");
+	printf(" %-42s  %s\n", "--use_overlap_scoring <true, false>",  "score bridging paths of paired-end reads by the overlapping paths of other reads, default: true");
 	printf(" %-42s  %s\n", "--min_flank_length <integer>",  "minimum match length in each side for a spliced read, default: 3");
 	printf(" %-42s  %s\n", "--min_num_reads_support_variant <integer>",  "minimum number of reads required to keep a SNP, default: 3");
 	return 0;
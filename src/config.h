@@ -70,6 +70,9 @@ using namespace std;
 #define TRANSCRIPT_COUNT_ONE_COVERAGE_ADD 5
 #define TRANSCRIPT_COUNT_ONE_COVERAGE_MAX 6
 
+#define MAX_DP_STACK_SIZE 16
+#define MAX_DP_TABLE_SIZE 262144
+
 // parameters
 // for bam file and reads
 extern int min_flank_length;
@@ -142,6 +145,11 @@ extern int min_transcript_length_increase;
 extern int min_exon_length;
 extern int max_num_exons;
 
+// for huge bundles
+extern int max_num_bundle_hits;
+extern long max_num_paths;
+extern double max_bundle_seconds;
+
 // for simulation
 extern int simulation_num_vertices;
 extern int simulation_num_edges;
@@ -151,26 +159,31 @@ extern int simulation_max_edge_weight;
 extern string algo;
 extern string input_file;
 extern string fasta_input;
-extern faidx_t *fai;
+extern int fasta_line_length;
 extern string ref_file;
 extern string ref_file1;
 extern string ref_file2;
 extern string vcf_file;
 extern string output_file;
 extern string output_file1;
+extern string stats_json_file;
+extern bool output_bgzf;
+extern string bundle_log_file;
+extern int bundle_log_top;
+extern bool bundle_log_graphs;
+extern string capture_file;
+extern string capture_region;
+extern double capture_min_seconds;
+extern string replay_file;
+extern int replay_rounds;
+extern string batch_file;
+extern int batch_jobs;
 extern set<string> chrofinterest;
 
 // AS info
 extern bool mask_WASP;
 extern int min_num_reads_support_variant;
-extern string vmap_chrm;
 extern vcf_data asp;
-extern map < string, map <int, map <string, genotype> > >     vcf_map;
-extern map < std::string, map <int, int > >                   vcf_map_len;
-extern map <int, map <string, genotype> >::iterator           vcf_map_it;
-extern map <int, int >::iterator                              vcf_map_len_it;
-extern map <int, map <string, genotype> >::iterator           vcf_map_end;
-extern map <int, int >::iterator                              vcf_map_len_end;
 extern double major_gt_threshold;  // min % for major allele in voting
 extern bool break_unphased_allelic_phasing;
 extern bool use_opposite_phasing;
@@ -187,6 +200,8 @@ extern int min_gtf_transcripts_num;
 extern int batch_bundle_size;
 extern int verbose;
 extern int assemble_duplicates;
+extern int num_threads;
+extern uint64_t random_seed;
 extern string version;
 extern bool to_revise_splice_graph;
 extern bool decompose_as_neighor;
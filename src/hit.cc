@@ -102,40 +102,105 @@ hit::hit(const hit &h)
 	umi = h.umi;
 }
 
+hit::hit(istream &fin)
+{
+	read_binary(fin, (bam1_core_t&)(*this));
+	read_binary(fin, hid);
+	read_binary(fin, qhash);
+	read_binary(fin, chrm);
+	read_binary(fin, rpos);
+	read_binary(fin, qlen);
+	read_binary(fin, qname);
+	read_binary(fin, strand);
+	read_binary(fin, xs);
+	read_binary(fin, ts);
+	read_binary(fin, nh);
+	read_binary(fin, hi);
+	read_binary(fin, nm);
+	read_binary(fin, umi);
+	read_as_pos_list(fin, spos);
+	read_as_pos_list(fin, apos);
+	read_as_pos_list(fin, itvm);
+	read_as_pos_list(fin, itvi);
+	read_as_pos_list(fin, itvd);
+	read_as_pos_list(fin, itv_align);
+	paired = false;
+	bridged = false;
+	next = NULL;
+	pi = -1;
+	fidx = -1;
+}
+
+// the features built from the bam record, without the per-bundle state (pairing, bridging, vlist)
+int hit::write(ostream &fout) const
+{
+	write_binary(fout, (const bam1_core_t&)(*this));
+	write_binary(fout, hid);
+	write_binary(fout, qhash);
+	write_binary(fout, chrm);
+	write_binary(fout, rpos);
+	write_binary(fout, qlen);
+	write_binary(fout, qname);
+	write_binary(fout, strand);
+	write_binary(fout, xs);
+	write_binary(fout, ts);
+	write_binary(fout, nh);
+	write_binary(fout, hi);
+	write_binary(fout, nm);
+	write_binary(fout, umi);
+	write_as_pos_list(fout, spos);
+	write_as_pos_list(fout, apos);
+	write_as_pos_list(fout, itvm);
+	write_as_pos_list(fout, itvi);
+	write_as_pos_list(fout, itvd);
+	write_as_pos_list(fout, itv_align);
+	return 0;
+}
+
+int write_as_pos_list(ostream &fout, const vector<as_pos> &v)
+{
+	uint32_t n = v.size();
+	write_binary(fout, n);
+	for(int i = 0; i < v.size(); i++)
+	{
+		write_binary(fout, v[i].p64);
+		write_binary(fout, v[i].ale);
+	}
+	return 0;
+}
+
+int read_as_pos_list(istream &fin, vector<as_pos> &v)
+{
+	uint32_t n = 0;
+	read_binary(fin, n);
+	v.resize(n);
+	for(int i = 0; i < n; i++)
+	{
+		read_binary(fin, v[i].p64);
+		read_binary(fin, v[i].ale);
+	}
+	return 0;
+}
+
 // hit::~hit()
 // {
 // }
 
 
-hit::hit(bam1_t *b, std::string chrm_name, int id) 
+hit::hit(bam1_t *b, std::string chrm_name, int id, worker_context &wc) 
 	:bam1_core_t(b->core), hid(id)
 {
 	chrm = chrm_name;
-	build_features(b);
-	build_aligned_intervals();
+	build_features(b, wc);
+	build_aligned_intervals(wc.vc);
 }
 
-int hit::build_features(bam1_t *b)
+int hit::build_features(bam1_t *b, worker_context &wc)
 {
 	// preparation for var 
-	bool do_apos = true;
-	if (vcf_file == "") do_apos = false;
-	if (vmap_chrm != chrm)
-	{
-		try
-		{
-			vcf_map_it = vcf_map.at(chrm).begin();
-			vcf_map_end = vcf_map.at(chrm).end();
-			vcf_map_len_it =  vcf_map_len.at(chrm).begin();
-			vcf_map_len_end = vcf_map_len.at(chrm).end();
-			vmap_chrm = chrm;
-		}
-		catch (std::out_of_range)
-		{
-			vmap_chrm = "";
-			do_apos = false;
-		}
-	}
+	variant_cursor &vc = wc.vc;
+	vc.seek(wc.rc.vcf, chrm);
+	bool do_apos = (vc.it != vc.end);
 	// get vW
 	uint8_t vw = 0;
 	if(mask_WASP)
@@ -196,14 +261,14 @@ int hit::build_features(bam1_t *b)
 		
 			// AS related
 			// map<genotype, int> gt_count;
-			auto it = vcf_map_it;
-			auto it_len = vcf_map_len_it;
-			for ( ; it != vcf_map_end && it_len!= vcf_map_len_end; vcf_data::increse_it(it, it_len))					// iterate through vcf
+			auto it = vc.it;
+			auto it_len = vc.len_it;
+			for ( ; it != vc.end && it_len!= vc.len_end; vcf_data::increse_it(it, it_len))					// iterate through vcf
 			{	
 				if (it->first >= p)  break;
 				if (it->first <  s)  
 				{
-					if (it->first < pos) { vcf_map_it = it; vcf_map_len_it = it_len;}
+					if (it->first < pos) { vc.it = it; vc.len_it = it_len;}
 					continue;
 				}
 				if(it_len->second != 1) continue;
@@ -274,7 +339,7 @@ int hit::build_features(bam1_t *b)
 ** build aligned intervals from spos + apos
 ** augment apos if a variant site is covered by spos but not itvm
 */
-int hit::build_aligned_intervals()
+int hit::build_aligned_intervals(const variant_cursor &vc)
 {
 	itv_align.clear();
 
@@ -297,9 +362,9 @@ int hit::build_aligned_intervals()
 	{
 		int sl = itvs_it.first;
 		int sr = itvs_it.second;
-		auto it = vcf_map_it;
-		auto it_len = vcf_map_len_it;
-		for ( ; it != vcf_map_end && it_len!= vcf_map_len_end; vcf_data::increse_it(it, it_len))					// iterate through vcf
+		auto it = vc.it;
+		auto it_len = vc.len_it;
+		for ( ; it != vc.end && it_len!= vc.len_end; vcf_data::increse_it(it, it_len))					// iterate through vcf
 		{	
 			if(it->first >= sr)  break;
 			if(it->first <  sl)  continue;
@@ -476,7 +541,7 @@ int hit::set_tags(bam1_t *b)
 // 	return 0;
 // }
 
-int hit::set_strand()
+int hit::set_strand(int library_type)
 {
 	strand = '.';
 	
@@ -15,10 +15,12 @@ See LICENSE for licensing.
 
 #include <string>
 #include <vector>
+#include <iostream>
 
 #include "htslib/sam.h"
 #include "config.h"
 #include "as_pos.hpp"
+#include "run_context.h"
 
 using namespace std;
 
@@ -53,8 +55,9 @@ class hit: public bam1_core_t
 public:
 	//hit(int32_t p);
 	//hit(bam1_t *b, std::string chrm_name);
-	hit(bam1_t *b, std::string chrm_name, int id);
+	hit(bam1_t *b, std::string chrm_name, int id, worker_context &wc);
 	hit(const hit &h);
+	hit(istream &fin);						// read a hit written by write()
 	// ~hit();
 	bool operator<(const hit &h) const;
 	hit& operator=(const hit &h);
@@ -91,14 +94,15 @@ public:
 	int fidx;						// its fragments index
 
 public:
-	int build_features(bam1_t *b);
-	int build_aligned_intervals();
+	int build_features(bam1_t *b, worker_context &wc);		// advances wc.vc
+	int build_aligned_intervals(const variant_cursor &vc);
+	int write(ostream &fout) const;
 	
 
 public:
 	static string get_qname(bam1_t *b);
 	int set_tags(bam1_t *b);
-	int set_strand();
+	int set_strand(int library_type);
 	int get_aligned_intervals(vector<as_pos> &v) const;
 	int print(bool to_print=false) const;
 	bool has_variant() const;
@@ -107,5 +111,7 @@ public:
 
 vector<int> encode_vlist(const vector<int> &v);
 vector<int> decode_vlist(const vector<int> &v);
+int write_as_pos_list(ostream &fout, const vector<as_pos> &v);
+int read_as_pos_list(istream &fin, vector<as_pos> &v);
 
 #endif
@@ -72,9 +72,9 @@ int hyper_set::add_edge_list(const MVII& s)
 
 /* 
 **  transform original-indexed hs to new-indexed hs
-**  original i2e ---> (origianl edge_descriptor) ---> x2y ---> (new edge_descriptor) ---> e2i ---> (new edge index)
+**  original index ---> x2y ---> (new edge_descriptor) ---> e2i ---> (new edge index)
 */
-int hyper_set::transform(const directed_graph* pgr, const VE& i2e_old, const MEE& x2y, const MEI& e2i_new)
+int hyper_set::transform(const directed_graph* pgr, const VE& x2y, const MEI& e2i_new)
 {
 	assert(nodes.size() == 0);  // transform is only compatible w. add_edge_list, where nodes are never used
 	assert(edges.size() == 0);
@@ -82,7 +82,6 @@ int hyper_set::transform(const directed_graph* pgr, const VE& i2e_old, const MEE
 	
 	if(edges_to_transform.size() == 0 && DEBUG_MODE_ON && verbose >= 3) cout << "hyper_set is empty when transforming!" << endl;
 	if(edges_to_transform.size() == 0 && DEBUG_MODE_ON && verbose >= 3) cerr << "hyper_set is empty when transforming!" << endl;
-	/* if (DEBUG_MODE_ON) for(const auto& es: edges_to_transform) {for(int i: es) cout << i2e_old[i] <<" "; cout <<endl;} */
 	
 	vector<int> ecnts_transformed;	
 	for(int i = 0; i < edges_to_transform.size(); i++)
@@ -99,14 +98,10 @@ int hyper_set::transform(const directed_graph* pgr, const VE& i2e_old, const MEE
 				continue;
 			}
 
-			assert(k >= 0 && k < i2e_old.size());
-			auto e_old = i2e_old[k]; 				// index ---> original edge_descriptor
-			assert(e_old != null_edge);
-			
-			auto x2yit = x2y.find(e_old);  			// original edges descriptor ---> new edge descriptor
-			assert(x2yit != x2y.end());
+			assert(k >= 0 && k < x2y.size());
+			auto e_new = x2y[k]; 					// original index ---> new edge descriptor
+			assert(e_new != null_edge);
 
-			auto e_new = x2yit->second;
 			auto e2iit = e2i_new.find(e_new);  		// new edge descriptor ---> new index			
 
 			if(pgr->edge(e_new).second && e2iit != e2i_new.end()) 
@@ -8,6 +8,7 @@ See LICENSE for licensing.
 
 #include "interval_map.h"
 #include "as_pos32.hpp"
+#include <algorithm>
 
 
 int32_t compute_overlap(const split_interval_map &imap, as_pos32 p)
@@ -42,9 +43,11 @@ SIMI locate_left_iterator(const split_interval_map &imap, as_pos32 x)
 	return it;
 }
 
-PSIMI locate_boundary_iterators(const split_interval_map &imap, as_pos32 x, as_pos32 y)
+// shared by split_interval_map and flat_interval_map
+template<class M>
+static pair<typename M::const_iterator, typename M::const_iterator> locate_boundary(const M &imap, as_pos32 x, as_pos32 y)
 {
-	SIMI lit, rit;
+	typename M::const_iterator lit, rit;
 	lit = locate_right_iterator(imap, x);
 	if(lit == imap.end() || upper(lit->first) > y) lit = imap.end();
 
@@ -58,15 +61,40 @@ PSIMI locate_boundary_iterators(const split_interval_map &imap, as_pos32 x, as_p
 		assert(lit == imap.end());
 	}
 
-	return PSIMI(lit, rit); 
+	return make_pair(lit, rit); 
 }
 
-int32_t compute_max_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
+// same as locate_boundary, but found by walking from hint instead of searching;
+// hint is left at the first interval with lower >= x, so queries with increasing x walk imap once
+template<class M>
+static pair<typename M::const_iterator, typename M::const_iterator> walk_boundary(const M &imap, typename M::const_iterator &hint, as_pos32 x, as_pos32 y)
+{
+	typename M::const_iterator it = hint;
+	while(it != imap.begin())
+	{
+		typename M::const_iterator p = it;
+		p--;
+		if(lower(p->first) < x) break;
+		it = p;
+	}
+	while(it != imap.end() && lower(it->first) < x) it++;
+	hint = it;
+
+	if(it == imap.end() || upper(it->first) > y) return make_pair(imap.end(), imap.end());
+
+	typename M::const_iterator rit = it;
+	typename M::const_iterator q = it;
+	for(q++; q != imap.end() && upper(q->first) <= y; q++) rit = q;
+	return make_pair(it, rit);
+}
+
+template<class M>
+static int32_t max_overlap(const M &imap, typename M::const_iterator &p, typename M::const_iterator &q)
 {
 	if(p == imap.end()) return 0;
 
 	int32_t s = 0;
-	for(SIMI it = p; it != q; it++)
+	for(typename M::const_iterator it = p; it != q; it++)
 	{
 		int32_t x = it->second;
 		if(x > s) s = x;
@@ -81,12 +109,13 @@ int32_t compute_max_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
 	return s;
 }
 
-int32_t compute_sum_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
+template<class M>
+static int32_t sum_overlap(const M &imap, typename M::const_iterator &p, typename M::const_iterator &q)
 {
 	if(p == imap.end()) return 0;
 
 	int32_t s = 0;
-	for(SIMI it = p; it != q; it++)
+	for(typename M::const_iterator it = p; it != q; it++)
 	{
 		int l = lower(it->first);
 		int u = upper(it->first);
@@ -104,22 +133,22 @@ int32_t compute_sum_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
 	return s;
 }
 
-int evaluate_rectangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
+template<class M>
+static int rectangle(const M &imap, const pair<typename M::const_iterator, typename M::const_iterator> &pei, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
 {
 	ave = 0;
 	dev = 1.0;
 
-	PSIMI pei = locate_boundary_iterators(imap, ll, rr); //typedef pair<SIMI, SIMI> PSIMI;
-	SIMI lit = pei.first, rit = pei.second; // typedef split_interval_map::const_iterator SIMI;
+	typename M::const_iterator lit = pei.first, rit = pei.second;
 
-	if(lit == imap.end()) return 0;
-	if(rit == imap.end()) return 0;
+	if(lit == imap.end()) return -1;
+	if(rit == imap.end()) return -1;
 
-	ave = 1.0 * compute_sum_overlap(imap, lit, rit) / (rr - ll);
+	ave = 1.0 * sum_overlap(imap, lit, rit) / (rr - ll);
 	//printf("compute average %d-%d = %.2lf\n", ll, rr, ave);
 
 	double var = 0;
-	for(SIMI it = lit; ; it++)
+	for(typename M::const_iterator it = lit; ; it++)
 	{
 		assert(upper(it->first) > lower(it->first));
 		var += (it->second - ave) * (it->second - ave) * (upper(it->first) - lower(it->first));
@@ -130,10 +159,119 @@ int evaluate_rectangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr,
 	dev = sqrt(var / (rr - ll));
 	//if(dev < 1.0) dev = 1.0;
 	
-	max = 1.0 * compute_max_overlap(imap, lit, rit);
+	max = 1.0 * max_overlap(imap, lit, rit);
+	return 0;
+}
+
+PSIMI locate_boundary_iterators(const split_interval_map &imap, as_pos32 x, as_pos32 y)
+{
+	return locate_boundary(imap, x, y);
+}
+
+int32_t compute_max_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
+{
+	return max_overlap(imap, p, q);
+}
+
+int32_t compute_sum_overlap(const split_interval_map &imap, SIMI &p, SIMI &q)
+{
+	return sum_overlap(imap, p, q);
+}
+
+PSIMI locate_boundary_iterators(const split_interval_map &imap, SIMI &hint, as_pos32 x, as_pos32 y)
+{
+	return walk_boundary(imap, hint, x, y);
+}
+
+int evaluate_rectangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
+{
+	return rectangle(imap, locate_boundary(imap, ll, rr), ll, rr, ave, dev, max);
+}
+
+int evaluate_rectangle(const split_interval_map &imap, SIMI &hint, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
+{
+	return rectangle(imap, walk_boundary(imap, hint, ll, rr), ll, rr, ave, dev, max);
+}
+
+int build_flat_interval_map(vector< pair<int32_t, int> > &events, flat_interval_map &fmap)
+{
+	fmap.clear();
+	sort(events.begin(), events.end());
+
+	int c = 0;
+	for(int i = 0; i < events.size(); )
+	{
+		int32_t p = events[i].first;
+		for(; i < events.size() && events[i].first == p; i++) c += events[i].second;
+		assert(c >= 0);
+		if(c == 0 || i >= events.size()) continue;
+		fmap.push_back(make_pair(ROI(p, events[i].first), c));
+	}
+	assert(c == 0);
 	return 0;
 }
 
+static bool compare_segment_lower(const pair<ROI, int> &s, const as_pos32 &x)
+{
+	return lower(s.first) < x;
+}
+
+static bool compare_segment_upper(const as_pos32 &x, const pair<ROI, int> &s)
+{
+	return x < upper(s.first);
+}
+
+// same as split_interval_map::upper_bound(ROI(x - 1, x)): first segment with lower >= x
+FIMI locate_right_iterator(const flat_interval_map &fmap, as_pos32 x)
+{
+	return lower_bound(fmap.begin(), fmap.end(), x, compare_segment_lower);
+}
+
+// same walk as for split_interval_map, starting from lower_bound(ROI(x - 1, x)): first segment with upper > x - 1
+FIMI locate_left_iterator(const flat_interval_map &fmap, as_pos32 x)
+{
+	FIMI it = upper_bound(fmap.begin(), fmap.end(), as_pos32(x - 1), compare_segment_upper);
+	if(it == fmap.end() && it == fmap.begin()) return it;
+	if(it == fmap.end()) it--;
+
+	while(upper(it->first) > x)
+	{
+		if(it == fmap.begin()) return fmap.end();
+		it--;
+	}
+	return it;
+}
+
+PFIMI locate_boundary_iterators(const flat_interval_map &fmap, as_pos32 x, as_pos32 y)
+{
+	return locate_boundary(fmap, x, y);
+}
+
+int compute_max_overlap(const flat_interval_map &fmap, FIMI &p, FIMI &q)
+{
+	return max_overlap(fmap, p, q);
+}
+
+int compute_sum_overlap(const flat_interval_map &fmap, FIMI &p, FIMI &q)
+{
+	return sum_overlap(fmap, p, q);
+}
+
+PFIMI locate_boundary_iterators(const flat_interval_map &fmap, FIMI &hint, as_pos32 x, as_pos32 y)
+{
+	return walk_boundary(fmap, hint, x, y);
+}
+
+int evaluate_rectangle(const flat_interval_map &fmap, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
+{
+	return rectangle(fmap, locate_boundary(fmap, ll, rr), ll, rr, ave, dev, max);
+}
+
+int evaluate_rectangle(const flat_interval_map &fmap, FIMI &hint, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max)
+{
+	return rectangle(fmap, walk_boundary(fmap, hint, ll, rr), ll, rr, ave, dev, max);
+}
+
 /**
  * find (x, y): returns first ROI with any overlapping, or end()
  * lowerbound(ROI(x, y)): returns first ROI strictly not less (ROI's upper > x) maybe with overlapping or end()
@@ -34,6 +34,11 @@ typedef icl::split_interval_map<as_pos32, int, icl::partial_absorber, less, icl:
 typedef split_interval_map::const_iterator SIMI;
 typedef pair<SIMI, SIMI> PSIMI;
 
+// flat split interval map: sorted disjoint segments with positive overlap, built by one sweep
+typedef vector< pair<ROI, int> > flat_interval_map;
+typedef flat_interval_map::const_iterator FIMI;
+typedef pair<FIMI, FIMI> PFIMI;
+
 
 // return the overlap at position p
 int compute_overlap(const split_interval_map &imap, as_pos32 p);
@@ -47,6 +52,9 @@ SIMI locate_left_iterator(const split_interval_map &imap, as_pos32 x);
 // locate boundary iterators
 PSIMI locate_boundary_iterators(const split_interval_map &imap, as_pos32 x, as_pos32 y);
 
+// same as above, walking from hint; hint is moved to the first interval with lower >= x
+PSIMI locate_boundary_iterators(const split_interval_map &imap, SIMI &hint, as_pos32 x, as_pos32 y);
+
 // return the sum of the lengths of intervals from p to q (include q)
 // int compute_coverage(const split_interval_map &imap, SIMI &p, SIMI &q);
 
@@ -56,11 +64,25 @@ int compute_max_overlap(const split_interval_map &imap, SIMI &p, SIMI &q);
 // return the sum of the overlap of the intervals from p to q (include q)
 int compute_sum_overlap(const split_interval_map &imap, SIMI &p, SIMI &q);
 
-// evaluate a region
+// evaluate a region, return -1 if no interval lies in [ll, rr)
 // int evaluate_rectangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr, double &ave, double &dev);
 int evaluate_rectangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max);
+int evaluate_rectangle(const split_interval_map &imap, SIMI &hint, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max);
 // int evaluate_triangle(const split_interval_map &imap, as_pos32 ll, as_pos32 rr, double &ave, double &dev);
 
+// build fmap from events (p, +1) and (q, -1) of intervals [p, q); same segments as adding them to a split_interval_map
+int build_flat_interval_map(vector< pair<int32_t, int> > &events, flat_interval_map &fmap);
+
+// counterparts of the above for flat_interval_map, with identical semantics
+FIMI locate_right_iterator(const flat_interval_map &fmap, as_pos32 x);
+FIMI locate_left_iterator(const flat_interval_map &fmap, as_pos32 x);
+PFIMI locate_boundary_iterators(const flat_interval_map &fmap, as_pos32 x, as_pos32 y);
+PFIMI locate_boundary_iterators(const flat_interval_map &fmap, FIMI &hint, as_pos32 x, as_pos32 y);
+int compute_max_overlap(const flat_interval_map &fmap, FIMI &p, FIMI &q);
+int compute_sum_overlap(const flat_interval_map &fmap, FIMI &p, FIMI &q);
+int evaluate_rectangle(const flat_interval_map &fmap, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max);
+int evaluate_rectangle(const flat_interval_map &fmap, FIMI &hint, as_pos32 ll, as_pos32 rr, double &ave, double &dev, double &max);
+
 
 // testing
 int test_split_interval_map();
@@ -19,14 +19,15 @@ See LICENSE for licensing.
 #include "config.h"
 #include "previewer.h"
 #include "assembler.h"
+#include "run_stats.h"
+#include "run_context.h"
+#include "batch.h"
 
 using namespace std;
 
 int main(int argc, const char **argv)
 {
 
-	srand(time(0));
-
 	if(argc == 1)
 	{
 		print_copyright();
@@ -38,6 +39,7 @@ int main(int argc, const char **argv)
 	}
 
 	parse_arguments(argc, argv);
+	srand(random_seed);
 
 	
 		
@@ -51,13 +53,30 @@ int main(int argc, const char **argv)
 		if (verbose >= 3) print_parameters();
 	}
 	
-	previewer pv;
-	pv.preview();
+	run_config rc;
+	if(batch_file != "")
+	{
+		batch bt(batch_file);
+		if(bt.run() != 0) return 1;
+	}
+	else if(replay_file != "")
+	{
+		// library type and insert sizes are restored from the capture file
+		assembler asmb(rc);
+		if(asmb.replay(replay_file) != 0) return 1;
+	}
+	else
+	{
+		previewer pv(rc);
+		if(pv.preview() != 0) return 1;
 
-	if(preview_only == true) return 0;
+		if(preview_only == true) return 0;
+
+		assembler asmb(rc);
+		if(asmb.assemble() != 0) return 1;
+	}
 
-	assembler asmb;
-	asmb.assemble();
+	if(stats_json_file != "") rstats.write(stats_json_file);
 
 	printf("Altai is completed.\n");
 
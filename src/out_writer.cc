@@ -0,0 +1,180 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cassert>
+
+#include "out_writer.h"
+#include "config.h"
+
+static const size_t out_block_size = 1 << 22;
+
+out_writer::out_writer(const string &f, bool bgzf, hts_tpool *pool)
+	: file(f), fp(NULL), bz(NULL), failed(false)
+{
+	buf.reserve(out_block_size + (1 << 16));
+	if(bgzf)
+	{
+		bz = bgzf_open(file.c_str(), "w");
+		if(bz != NULL && pool != NULL) bgzf_thread_pool(bz, pool, 0);
+	}
+	else
+	{
+		fp = fopen(file.c_str(), "w");
+	}
+	if(fp == NULL && bz == NULL) failed = true;
+}
+
+out_writer::~out_writer()
+{
+	close();
+}
+
+bool out_writer::fail() const
+{
+	return failed;
+}
+
+int out_writer::flush_full()
+{
+	if(buf.size() < out_block_size) return 0;
+	return flush();
+}
+
+int out_writer::write_error()
+{
+	if(failed == false) printf("error: cannot write %s\n", file.c_str());
+	failed = true;
+	return 0;
+}
+
+// a block goes to the file right away, so that a full disk is noticed by the next fail()
+int out_writer::flush()
+{
+	if(buf.size() == 0) return 0;
+	if(fp != NULL && (fwrite(buf.data(), 1, buf.size(), fp) != buf.size() || fflush(fp) != 0)) write_error();
+	if(bz != NULL && bgzf_write(bz, buf.data(), buf.size()) < 0) write_error();
+	buf.clear();
+	return 0;
+}
+
+int out_writer::close()
+{
+	flush();
+	if(fp != NULL && fclose(fp) != 0) write_error();
+	if(bz != NULL && bgzf_close(bz) != 0) write_error();
+	fp = NULL;
+	bz = NULL;
+	return failed ? -1 : 0;
+}
+
+int out_writer::write(const vector<transcript> &v, bool gvf)
+{
+	for(int i = 0; i < v.size(); i++)
+	{
+		if(gvf) v[i].format_gvf(buf);
+		else v[i].format(buf);
+		flush_full();
+	}
+	return 0;
+}
+
+allele_output::allele_output(int a, const run_config &rc, hts_tpool *pool)
+	: gtf(NULL), gvf(NULL), spec_gtf(NULL), spec_gvf(NULL), nonfull_gvf(NULL), recov_gvf(NULL), fa(NULL), open_failed(false)
+{
+	assert(a >= 0 && a <= 2);
+	string allele_name_fix;
+	if (a == 0) allele_name_fix = "merged";
+	if (a == 1) allele_name_fix = "allele1";
+	if (a == 2) allele_name_fix = "allele2";
+	string outname_prefix = rc.output_file + "." + allele_name_fix;
+	string gz = output_bgzf ? ".gz" : "";
+
+	if (rc.output_file != "")
+	{
+		gtf = open(outname_prefix + ".gtf" + gz, output_bgzf, pool);
+		gvf = open(outname_prefix + ".gvf" + gz, output_bgzf, pool);
+		if(gvf != NULL) gvf->buf += "#allele \"ALLELE1/2\" correspondes to the first/second allele of \"GT\" field in the vcf file input.\n";
+	}
+
+	// fasta w/ variants
+	if(rc.fasta_file != "") fa = open(outname_prefix + ".fa" + gz, output_bgzf, pool);
+
+	// specific transcritps' gtf and gvf
+	if (rc.output_file != "")
+	{
+		if (a == 0) outname_prefix = rc.output_file + "." + "nonspec.multi-exon";
+		if (a == 1) outname_prefix = rc.output_file + "." + "allele1spec.multi-exon";
+		if (a == 2) outname_prefix = rc.output_file + "." + "allele2spec.multi-exon";
+		spec_gvf = open(outname_prefix + ".gvf" + gz, output_bgzf, pool);
+		spec_gtf = open(outname_prefix + ".gtf" + gz, output_bgzf, pool);
+	}
+
+	if(rc.output_file1 != "") nonfull_gvf = open(rc.output_file1 + "." + allele_name_fix + ".gvf" + gz, output_bgzf, pool);
+
+	if(recover_partial_tx_min_overlap_with_full_tx > 0 && a != 0)
+	{
+		recov_gvf = open(rc.output_file1 + ".re." + allele_name_fix + ".gvf" + gz, output_bgzf, pool);
+	}
+}
+
+allele_output::~allele_output()
+{
+	if(gtf != NULL) delete gtf;
+	if(gvf != NULL) delete gvf;
+	if(spec_gtf != NULL) delete spec_gtf;
+	if(spec_gvf != NULL) delete spec_gvf;
+	if(nonfull_gvf != NULL) delete nonfull_gvf;
+	if(recov_gvf != NULL) delete recov_gvf;
+	if(fa != NULL) delete fa;
+}
+
+out_writer *allele_output::open(const string &file, bool bgzf, hts_tpool *pool)
+{
+	out_writer *w = new out_writer(file, bgzf, pool);
+	if(w->fail() == false) return w;
+
+	printf("open file %s error\n", file.c_str());
+	open_failed = true;
+	delete w;
+	return NULL;
+}
+
+bool allele_output::fail() const
+{
+	const out_writer *w[7] = {gtf, gvf, spec_gtf, spec_gvf, nonfull_gvf, recov_gvf, fa};
+	for(int i = 0; i < 7; i++) if(w[i] != NULL && w[i]->fail()) return true;
+	return open_failed;
+}
+
+int allele_output::close()
+{
+	out_writer *w[7] = {gtf, gvf, spec_gtf, spec_gvf, nonfull_gvf, recov_gvf, fa};
+	for(int i = 0; i < 7; i++) if(w[i] != NULL) w[i]->close();
+	return fail() ? -1 : 0;
+}
+
+int allele_output::append(out_writer *w, const vector<transcript> &v, bool gvf)
+{
+	if(w == NULL) return 0;
+	w->write(v, gvf);
+	return 0;
+}
+
+int allele_output::write(const vector<transcript> &full, const vector<transcript> &specific, const vector<transcript> &nonfull, const vector<transcript> &recovered, const string &fasta)
+{
+	append(gtf, full, false);
+	append(gvf, full, true);
+	append(spec_gvf, specific, true);
+	append(spec_gtf, specific, false);
+	append(nonfull_gvf, nonfull, true);
+	append(recov_gvf, recovered, true);
+	if(fa != NULL)
+	{
+		fa->buf += fasta;
+		fa->flush_full();
+	}
+	return 0;
+}
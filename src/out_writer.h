@@ -0,0 +1,80 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __OUT_WRITER_H__
+#define __OUT_WRITER_H__
+
+#include <string>
+#include <cstdio>
+
+#include "htslib/bgzf.h"
+#include "htslib/hts.h"
+#include "transcript.h"
+#include "run_context.h"
+
+using namespace std;
+
+/*
+**	out_writer collects formatted lines in a large buffer and writes it in blocks,
+**	either as plain text or BGZF-compressed (optionally through an htslib thread pool)
+*/
+class out_writer
+{
+public:
+	out_writer(const string &file, bool bgzf, hts_tpool *pool = NULL);
+	~out_writer();
+
+public:
+	string buf;						// append lines here, then call flush_full()
+
+public:
+	bool fail() const;				// not opened, or a write failed
+	int flush_full();				// writes buf once it grows beyond the block size
+	int flush();
+	int close();					// -1 if anything failed
+	int write(const vector<transcript> &v, bool gvf);
+
+private:
+	string file;
+	FILE *fp;
+	BGZF *bz;
+	bool failed;
+
+private:
+	int write_error();				// reports the first failed write
+};
+
+/*
+**	allele_output keeps the output files of one allele (0: merged, 1: ALLELE1, 2: ALLELE2) open
+**	for the whole run; the transcripts of each finished chromosome are appended in order
+*/
+class allele_output
+{
+public:
+	allele_output(int a, const run_config &rc, hts_tpool *pool);
+	~allele_output();
+
+public:
+	int write(const vector<transcript> &full, const vector<transcript> &specific, const vector<transcript> &nonfull, const vector<transcript> &recovered, const string &fasta);
+	bool fail() const;			// a file could not be written
+	int close();				// -1 if a file could not be written
+
+private:
+	out_writer *gtf;			// full-length transcripts
+	out_writer *gvf;			// full-length transcripts with variants
+	out_writer *spec_gtf;		// allele-specific (or non-specific, for merged) multi-exon transcripts
+	out_writer *spec_gvf;
+	out_writer *nonfull_gvf;	// non-full-length transcripts, with -f
+	out_writer *recov_gvf;		// recovered partial transcripts
+	out_writer *fa;				// sequences of the full-length transcripts, with -G
+	bool open_failed;
+
+private:
+	out_writer *open(const string &file, bool bgzf, hts_tpool *pool);
+	int append(out_writer *w, const vector<transcript> &v, bool gvf);
+};
+
+#endif
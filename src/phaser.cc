@@ -10,11 +10,15 @@ See LICENSE for licensing.
 #include "vertex_info.h"
 #include "as_pos32.hpp"
 #include "specific_trsts.hpp"
+#include "run_stats.h"
 #include <limits.h>
+#include <thread>
+#include <functional>
 
 phaser::phaser(scallop& _sc, bool _is_allelic)
 	: sc(_sc), gr(_sc.gr), is_allelic(_is_allelic)
 {
+	stage_timer st(STAGE_PHASER);
 	sc.gr.edge_integrity_examine();
 	sc.gr.edge_integrity_enforce();
 
@@ -84,12 +88,7 @@ int phaser::init()
 
 	vwrt1.resize(gr.vwrt.size(), -1);
 	vwrt2.resize(gr.vwrt.size(), -1); 
-	for(auto i: gr.ewrt)
-	{
-		edge_descriptor e = i.first;
-		ewrt1.insert({e, -1});
-		ewrt2.insert({e, -1});
-	}
+	init_edge_order();
 
 	vwrtbg1 = 0;
 	vwrtbg2 = 0;
@@ -106,21 +105,17 @@ int phaser::init()
 	{ 
 		if (gr.get_vertex_info(i).gt == ALLELE1)
 		{
-			PEEI in = gr.in_edges(i);
-			PEEI out = gr.out_edges(i);
-			for (auto e = in.first; e!= in.second; e++)	
+			for (int e : vin[i])
 			{
-				assert(gr.ewrt.find(*e) != gr.ewrt.end());
-				ewrt1[*e] = gr.ewrt[*e];
-				ewrt2[*e] = 0;
-				ewrtbg1 += gr.ewrt[*e];
+				ewrt1[e] = ewrt0[e];
+				ewrt2[e] = 0;
+				ewrtbg1 += ewrt0[e];
 			}
-			for (auto e = out.first; e!= out.second; e++)	
+			for (int e : vout[i])
 			{
-				assert(gr.ewrt.find(*e) != gr.ewrt.end());
-				ewrt1[*e] = gr.ewrt[*e];
-				ewrt2[*e] = 0;
-				ewrtbg1 += gr.ewrt[*e];
+				ewrt1[e] = ewrt0[e];
+				ewrt2[e] = 0;
+				ewrtbg1 += ewrt0[e];
 			}
 			vwrt1[i] = gr.get_vertex_weight(i);
 			vwrt2[i] = 0.0;
@@ -128,21 +123,17 @@ int phaser::init()
 		}
 		else if (gr.get_vertex_info(i).gt == ALLELE2)
 		{
-			PEEI in = gr.in_edges(i);
-			PEEI out = gr.out_edges(i);
-			for (auto e = in.first; e!= in.second; e++)	
+			for (int e : vin[i])
 			{
-				assert(gr.ewrt.find(*e) != gr.ewrt.end());
-				ewrt1[*e] = 0;
-				ewrt2[*e] = gr.ewrt[*e];
-				ewrtbg2 += gr.ewrt[*e];
+				ewrt1[e] = 0;
+				ewrt2[e] = ewrt0[e];
+				ewrtbg2 += ewrt0[e];
 			}
-			for (auto e = out.first; e!= out.second; e++)	
+			for (int e : vout[i])
 			{
-				assert(gr.ewrt.find(*e) != gr.ewrt.end());
-				ewrt1[*e] = 0;
-				ewrt2[*e] = gr.ewrt[*e];
-				ewrtbg2 += gr.ewrt[*e];
+				ewrt1[e] = 0;
+				ewrt2[e] = ewrt0[e];
+				ewrtbg2 += ewrt0[e];
 			}
 			vwrt1[i] = 0.0;
 			vwrt2[i] = gr.get_vertex_weight(i);
@@ -163,6 +154,42 @@ int phaser::init()
 	return 0;
 }
 
+/*
+**	index edges of gr by their index in sc.i2e, so that edge weights of gr/allele1/allele2 are plain vectors
+**	eorder lists edges by (source, target, weight) rather than by address, thus 
+**	the allelic graphs are copied (and later traversed) in the same order in every run
+*/
+int phaser::init_edge_order()
+{
+	int n = sc.i2e.size();
+	ewrt0.assign(n, -1);
+	ewrt1.assign(n, -1);
+	ewrt2.assign(n, -1);
+
+	vector< pair<PI, pair<double, int> > > v;
+	for(int j = 0; j < n; j++)
+	{
+		edge_descriptor e = sc.i2e[j];
+		if(e == null_edge) continue;
+		ewrt0[j] = gr.get_edge_weight(e);
+		v.push_back({{e->source(), e->target()}, {ewrt0[j], j}});
+	}
+	assert(v.size() == gr.num_edges());
+	sort(v.begin(), v.end());
+
+	eorder.clear();
+	vin.assign(gr.num_vertices(), vector<int>());
+	vout.assign(gr.num_vertices(), vector<int>());
+	for(int k = 0; k < v.size(); k++)
+	{
+		int j = v[k].second.second;
+		eorder.push_back(j);
+		vout[v[k].first.first].push_back(j);
+		vin[v[k].first.second].push_back(j);
+	}
+	return 0;
+}
+
 /*
 **	assign edges to different gt
 ** 	TODO: did not consider hs
@@ -185,29 +212,34 @@ int phaser::assign_gt()
 	assert(asnodes.size() >= 1);
 	assert(nsnodes.size() >= 1);
 
-	// split local; split nsnodes wrt descending AS ratio
+	// split local; always split the nsnode of the largest current AS ratio
+	// only nodes incident to edges assigned by the last split change their mae, so only they are refreshed
 	if (nsnodes.size() + asnodes.size() < max_num_exons)
 	{
-		while(nsnodes.size() >= 1)
+		set< pair<double, int> > mq;					// (mae, node) of nsnodes with valid mae; max at the end
+		vector<double> mae(gr.num_vertices(), -1);		// current key of node in mq, -1 if not in mq
+		for(int i : nsnodes) refresh_mae(i, mq, mae);
+
+		while(mq.size() >= 1)
 		{
-			vector<int> vi = sort_nodes_by_currecnt_mae(nsnodes);
-			if(vi.size() == 0) break;
-			bool b = false;
+			int i = prev(mq.end())->second;
+			mq.erase(prev(mq.end()));
+			mae[i] = -1;
+
+			set<int> nb;
+			for(int e : vin[i]) if(ewrt1[e] < 0) nb.insert(sc.i2e[e]->source());
+			for(int e : vout[i]) if(ewrt1[e] < 0) nb.insert(sc.i2e[e]->target());
 
-			for(int i : vi)
+			bool b = split_local(i);
+			assert(b);
+			assert(nsnodes.find(i) != nsnodes.end());
+			nsnodes.erase(i);
+
+			for(int j : nb)
 			{
-				if(split_local(i))
-				{
-					assert(nsnodes.find(i) != nsnodes.end());
-					nsnodes.erase(i);
-				} 
-				else 
-				{
-					b = true;
-					break;
-				}
+				if(nsnodes.find(j) == nsnodes.end()) continue;
+				refresh_mae(j, mq, mae);
 			}
-			if (b) break;
 		}
 	}
 	
@@ -223,65 +255,46 @@ int phaser::assign_gt()
 
 	// split global by edge
 	// in rare cases some edges are left b/c their nodes are isolated or edges remained while incidental nodes removed
-	for(const auto & ed: gr.ewrt)
+	for(int e : eorder)
 	{
-		split_global(ed.first);
+		split_global_edge(e);
 	}
 
 	return 0;
 }
 
-// returns nodes with valid mae only
-vector<int> phaser::sort_nodes_by_currecnt_mae(const set<int>& s)
+// update the key of node i in mq to its current mae; nodes without valid mae are kept out of mq
+int phaser::refresh_mae(int i, set< pair<double, int> >& mq, vector<double>& mae)
 {
-	vector< pair<double, int> > nodes_mae;
-	for(int i : s)
-	{
-		pair<double, double> r1r2 = get_as_ratio(i);
-		double mae = max(r1r2.first, r1r2.second);
-		if (mae <= 0) continue;
-		nodes_mae.push_back({mae, i});
-	}
+	if(mae[i] > 0) mq.erase({mae[i], i});
+	mae[i] = -1;
 
-	sort(nodes_mae.begin(), nodes_mae.end());
-	vector<int> nodes_descending_mae;
+	pair<double, double> r1r2 = get_as_ratio(i);
+	double m = max(r1r2.first, r1r2.second);
+	if (m <= 0) return 0;
 
-	for(auto i = nodes_mae.end(); i != nodes_mae.begin(); i--)
-	{
-		auto j = prev(i, 1);
-		if(DEBUG_MODE_ON) if(i!= nodes_mae.end()) 
-		{
-			cout << j->second << " " << j->first << " " << i->second  << " " << i->first << endl;
-			assert(j->first <= i->first);
-		}
-		assert(j->first > 0);
-		nodes_descending_mae.push_back(j->second);
-	}
-	
-	return nodes_descending_mae;
+	mae[i] = m;
+	mq.insert({m, i});
+	return 0;
 }
 
-
 /** 
  *	@param	i	node index
  *	@return		<ratio1, ratio2>, if abnormal <-1, -1>
  */ 
 pair<double, double> phaser::get_as_ratio(int i)
 {
-	vertex_info v = gr.get_vertex_info(i);
-	const PEEI in = gr.in_edges(i);
-	const PEEI out = gr.out_edges(i);
 	double local1 = 0;
 	double local2 = 0;
-	for (auto e = in.first; e!= in.second; e++)	
+	for (int e : vin[i])
 	{
-		if(ewrt1[*e] > 0)	local1 += ewrt1[*e];
-		if(ewrt2[*e] > 0)	local2 += ewrt2[*e]; 
+		if(ewrt1[e] > 0)	local1 += ewrt1[e];
+		if(ewrt2[e] > 0)	local2 += ewrt2[e]; 
 	}
-	for (auto e = out.first; e!= out.second; e++)
+	for (int e : vout[i])
 	{
-		if(ewrt1[*e] > 0)	local1 += ewrt1[*e];
-		if(ewrt2[*e] > 0)	local2 += ewrt2[*e]; 
+		if(ewrt1[e] > 0)	local1 += ewrt1[e];
+		if(ewrt2[e] > 0)	local2 += ewrt2[e]; 
 	}
 
 	assert(local1 >= 0);
@@ -304,12 +317,9 @@ bool phaser::split_local(int i)
 	if(ratio2 < 0) assert(ratio1 < 0);
 	if(ratio1 + ratio2 <= 0) return false;
 	
-	const PEEI in = gr.in_edges(i);
-	const PEEI out = gr.out_edges(i);
-	
 	if (strategy == "split_by_ratio")
 	{
-		return split_by_ratio(i, in, out, ratio1);
+		return split_by_ratio(i, ratio1);
 	}
 	else
 	{
@@ -325,11 +335,9 @@ bool phaser::split_global(int i)
 	assert(ewrtratiobg2 >= 0);
 	assert(ewrtratiobg1 + ewrtratiobg2 > 0);
 
-	const PEEI in = gr.in_edges(i);
-	const PEEI out = gr.out_edges(i);
 	if (strategy == "split_by_ratio")
 	{
-		return split_by_ratio(i, in, out, ewrtratiobg1);
+		return split_by_ratio(i, ewrtratiobg1);
 	}
 	else
 	{
@@ -338,19 +346,14 @@ bool phaser::split_global(int i)
 	}
 }
 
-bool phaser::split_global(edge_descriptor e)
+// e is the index of the edge in sc.i2e
+bool phaser::split_global_edge(int e)
 {
 	if(strategy != "split_by_ratio") assert (0);
-
-	if(DEBUG_MODE_ON)
-	{
-		assert(gr.ewrt.find(e) != gr.ewrt.end());
-		assert(ewrt1.find(e) != ewrt1.end());
-		assert(ewrt2.find(e) != ewrt2.end());
-	}
+	assert(e >= 0 && e < ewrt0.size());
 
 	double ratio_allele1 = ewrtratiobg1;
-	double w = gr.ewrt[e];
+	double w = ewrt0[e];
 	assert(w >= 0);
 	assert((ewrt1[e] < 0 && ewrt2[e] < 0) || (ewrt1[e] >= 0 && ewrt2[e] >= 0));
 
@@ -367,49 +370,26 @@ bool phaser::split_global(edge_descriptor e)
 
 //	split edges of vertex v, by ratio.
 //  directly modify ewrt1, ewrt2, if ewrt1[e] or ewrt2[e] <= -1 (not assigned)
-bool phaser::split_by_ratio(int v, const PEEI& in, const PEEI& out, double ratio_allele1)
+bool phaser::split_by_ratio(int v, double ratio_allele1)
 {
 	assert(ratio_allele1 > 0); // ratio normalized, won't equal. NaN handled bef calling
 	assert(ratio_allele1 < 1);
 
 	vwrt1[v] = gr.get_vertex_weight(v) * ratio_allele1;
 	vwrt2[v] = gr.get_vertex_weight(v) * (1 - ratio_allele1);
-	for (auto e = in.first; e!= in.second; e++)	
+	for (const vector<int>* ve : {&vin[v], &vout[v]})
 	{
-		if(DEBUG_MODE_ON)
+		for (int e : *ve)
 		{
-			assert(gr.ewrt.find(*e) != gr.ewrt.end());
-			assert(ewrt1.find(*e) != ewrt1.end());
-			assert(ewrt2.find(*e) != ewrt2.end());
-		}
-
-		double w = gr.ewrt[*e];
-		if(ewrt1[*e] < 0)
-		{
-			ewrt1[*e] = w * ratio_allele1;
-		} 
-		if(ewrt2[*e] < 0)
-		{
-			ewrt2[*e] = w * (1 - ratio_allele1);
-		} 
-	}
-	for (auto e = out.first; e!= out.second; e++)
-	{
-		if(DEBUG_MODE_ON)
-		{
-			assert(gr.ewrt.find(*e) != gr.ewrt.end());
-			assert(ewrt1.find(*e) != ewrt1.end());
-			assert(ewrt2.find(*e) != ewrt2.end());
-		}
-
-		double w = gr.ewrt[*e];
-		if(ewrt1[*e] < 0)
-		{
-			ewrt1[*e] = w * ratio_allele1;
-		} 
-		if(ewrt2[*e] < 0)
-		{
-			ewrt2[*e] = w * (1 - ratio_allele1);
+			double w = ewrt0[e];
+			if(ewrt1[e] < 0)
+			{
+				ewrt1[e] = w * ratio_allele1;
+			} 
+			if(ewrt2[e] < 0)
+			{
+				ewrt2[e] = w * (1 - ratio_allele1);
+			}
 		}
 	}
 	
@@ -435,47 +415,51 @@ int phaser::split_by_min_parsimony(int v, const PEEI& itr_in_edges, const PEEI&
 int phaser::split_gr()
 {	
 	sc.gr.edge_integrity_examine();
-	MED gr0_ewrt_copy;
-	if(DEBUG_MODE_ON) 
-	{	
-		gr0_ewrt_copy = gr.ewrt;
-		for (auto && ei0: gr0_ewrt_copy) assert(ei0.second >= 0);
-		for (auto && ei1: ewrt1) assert(ei1.second >= 0);
-		for (auto && ei2: ewrt2) assert(ei2.second >= 0);
-	}
 
-	x2y_1.clear();// use x2y to map original edge to new edge
-	y2x_1.clear();
-    x2y_2.clear();
-	y2x_2.clear();
+	// edges of gr, and their allelic weights, in the order of eorder
+	VE ve;
+	vector<double> ew1, ew2;
+	for (int e : eorder)
+	{
+		assert(ewrt0[e] >= 0);
+		assert(ewrt1[e] >= 0);
+		assert(ewrt2[e] >= 0);
+		ve.push_back(sc.i2e[e]);
+		ew1.push_back(ewrt1[e]);
+		ew2.push_back(ewrt2[e]);
+	}
 
 	//copy MEV(this is edge_discro), v2v
+	// vertex and edge weights of gr are replaced together, gr is left with those of allele2
+	VE ye1, ye2;
 	gr.vwrt = vwrt1;
-	gr.ewrt = ewrt1;
-	pgr1->copy(gr, x2y_1, y2x_1);
+	for (int k = 0; k < ve.size(); k++) gr.set_edge_weight(ve[k], ew1[k]);
+	pgr1->copy(gr, ve, ew1, ye1);
 
 	gr.vwrt = vwrt2;
-	gr.ewrt = ewrt2;	
-	pgr2->copy(gr, x2y_2, y2x_2);
+	for (int k = 0; k < ve.size(); k++) gr.set_edge_weight(ve[k], ew2[k]);
+	pgr2->copy(gr, ve, ew2, ye2);
+
+	// use x2y to map original edge index to new edge
+	x2y_1.assign(sc.i2e.size(), null_edge);
+	x2y_2.assign(sc.i2e.size(), null_edge);
+	for (int k = 0; k < eorder.size(); k++)
+	{
+		x2y_1[eorder[k]] = ye1[k];
+		x2y_2[eorder[k]] = ye2[k];
+	}
 
 	if(DEBUG_MODE_ON && print_phaser_detail) 
 	{
 		cout << "DEBUG phaser::split_gr()" << endl;
-		cout << "ewrt size:" << ewrt1.size() << endl;
+		cout << "ewrt size:" << eorder.size() << endl;
 		cout << "edge\tgr0.ewrt\tewrt1\tewrt2" << endl;
-		assert (ewrt1.size() == gr0_ewrt_copy.size());
-		assert (ewrt1.size() == ewrt2.size());
 
-		for (int j = 0; j < ewrt1.size(); j ++)
+		for (int e : eorder)
 		{
-			auto i = next(ewrt1.begin(), j);
-			auto k = next(ewrt2.begin(), j);
-			auto l = next(gr0_ewrt_copy.begin(), j);
-			assert (i->first == k->first);  // all edge_descriptors are the same before transform
-			assert (l->first == i->first);
-			cout << "edge " << i->first->source() << "->" << i->first->target();
-			cout << "\t" << l->first << ": " << l->second;
-			cout << "\t" << i->second << "\t"  << k->second << " " << endl;
+			cout << "edge " << sc.i2e[e]->source() << "->" << sc.i2e[e]->target();
+			cout << "\t" << sc.i2e[e] << ": " << ewrt0[e];
+			cout << "\t" << ewrt1[e] << "\t"  << ewrt2[e] << " " << endl;
 		}	
 
 		cout << "pgr1(order of ewrt may be different)\tsize: " << pgr1->ewrt.size() << "addr-" << pgr1 << endl;
@@ -535,7 +519,7 @@ int phaser::refine_allelic_graphs() // FIXME:
 		edge_iterator it1, it2;
 
 		// To avoid boundary error during removal, add edges into a set a prior.
-		set<edge_descriptor> edges_1;
+		SE edges_1;
 		for (pei = pgr->edges(), it1 = pei.first, it2 = pei.second; it1 != it2; it1++) edges_1.insert(*it1);
 		for (edge_descriptor e: edges_1)
 		{
@@ -567,7 +551,7 @@ int phaser::refine_allelic_graphs() // FIXME:
 		pgr2->edge_integrity_examine();
 		
 		cout << "pgr1-refine\tsize:" << pgr1->ewrt.size() << "\taddr-" << pgr1 << endl;
-		set<edge_descriptor> gr1edges;
+		SE gr1edges;
 		for (auto i:pgr1->ewrt) 
 		{
 			cout << "\t" << i.first << ": " << i.second << " " << endl;
@@ -576,7 +560,7 @@ int phaser::refine_allelic_graphs() // FIXME:
 		if (gr1edges.size() == 0 && ewrtbg1 > 0.05) cerr << pgr1->gid << "(ale1) is empty after refining but has non-empty AS weight" << endl;
 
 		cout << "pgr2-refine\tsize" << pgr2->ewrt.size() << "\taddr-" << pgr2 << endl;
-		set<edge_descriptor> gr2edges;
+		SE gr2edges;
 		for (auto i:pgr2->ewrt) 
 		{
 			cout << "\t" << i.first << ": " << i.second << " " << endl;
@@ -636,7 +620,7 @@ int phaser::smooth_allelic_graphs()
 		pgr2->edge_integrity_examine();
 		
 		cout << "pgr1-smooth\tsize:" << pgr1->ewrt.size() << "\taddr-" << pgr1 << endl;
-		set<edge_descriptor> gr1edges;
+		SE gr1edges;
 		for (auto i:pgr1->ewrt) 
 		{
 			cout << "\t" << i.first << ": " << i.second << " " << endl;
@@ -645,7 +629,7 @@ int phaser::smooth_allelic_graphs()
 		if (gr1edges.size() == 0 && ewrtbg1 > 0.05) cerr << pgr1->gid << "(ale1) is empty after smoothing but has non-empty AS weight" << endl;
 
 		cout << "pgr2-smooth\tsize" << pgr2->ewrt.size() << "\taddr-" << pgr2 << endl;
-		set<edge_descriptor> gr2edges;
+		SE gr2edges;
 		for (auto i:pgr2->ewrt) 
 		{
 			cout << "\t" << i.first << ": " << i.second << " " << endl;
@@ -683,7 +667,7 @@ int phaser::split_hs()
 		// only two potential alleles 
 		assert (i == 0 || i == 1); 
 		hyper_set*    phs      = (i == 0)? phs1  : phs2;
-		MED&          ewrt_cur = (i == 0)? ewrt1 : ewrt2;
+		const vector<double>& ewrt_cur = (i == 0)? ewrt1 : ewrt2;
 		
 		// copy hs0 to hs1/hs2; remove undesired edges
 		MVII edges_w_count;
@@ -701,12 +685,7 @@ int phaser::split_hs()
 				edge_descriptor e = sc.i2e[edge_idx];
 				if (e == null_edge) continue;
 				
-				if(ewrt_cur.find(e) == ewrt_cur.end())
-				{
-					use_this = false;
-					break;
-				}
-				double w = ewrt_cur[e];
+				double w = ewrt_cur[edge_idx];
 				assert(w >= 0);
 				if(w < bottleneck) bottleneck = w;
 				
@@ -795,12 +774,23 @@ int phaser::assemble_allelic_scallop()
 {
 	pgr1->gid = pgr1->gid + ".allele1";
 	pgr2->gid = pgr2->gid + ".allele2";
-	scallop sc1(pgr1,  *phs1, sc, true, false);
-	scallop sc2(pgr2,  *phs2, sc, true, false);	
-	allelic_transform(sc1, pgr1, x2y_1);
-	allelic_transform(sc2, pgr2, x2y_2);
-	sc1.assemble(is_allelic);  
-	sc2.assemble(is_allelic);  
+	scallop sc1(pgr1,  *phs1, sc, 1, true, false);
+	scallop sc2(pgr2,  *phs2, sc, 2, true, false);	
+
+	// two allelic instances share nothing but read-only sc; assemble allele2 in its own thread
+	if(num_threads >= 2)
+	{
+		stage_thread t2(&phaser::assemble_allele, this, ref(sc2), pgr2, ref(x2y_2));
+		assemble_allele(sc1, pgr1, x2y_1);
+		t2.join();
+	}
+	else
+	{
+		allelic_transform(sc1, pgr1, x2y_1);
+		allelic_transform(sc2, pgr2, x2y_2);
+		sc1.assemble(is_allelic);  
+		sc2.assemble(is_allelic);  
+	}
 
 	trsts1 = sc1.trsts;
 	trsts2 = sc2.trsts;
@@ -816,27 +806,38 @@ int phaser::assemble_allelic_scallop()
 	return 0;
 }
 
+/*
+** transform and assemble one allelic scallop instance
+** touches only sc1, pgr and x2y of this allele, so the two alleles may run concurrently
+*/
+int phaser::assemble_allele(scallop& sc1, splice_graph* pgr, VE& x2y)
+{
+	allelic_transform(sc1, pgr, x2y);
+	sc1.assemble(is_allelic);
+	return 0;
+}
+
 /*
 ** transforms edge_descriptor and other pointers from sc0/hs0 to new pointers, using x2y
 ** objects transformed: sc, hs
 */
-int phaser::allelic_transform(scallop& sc1, splice_graph* pgr, MEE& x2y)
+int phaser::allelic_transform(scallop& sc1, splice_graph* pgr, VE& x2y)
 {	
 	scallop* psc = &sc1;
 	if(DEBUG_MODE_ON && print_phaser_detail)
 	{	
-		set<edge_descriptor> sc_edges;
-		set<edge_descriptor> gr_edges;
-		set<edge_descriptor> mev_edges;
+		SE sc_edges;
+		SE gr_edges;
+		SE mev_edges;
 		PEEI sc_peei = psc->gr.edges();
 		PEEI gr_peei = pgr->edges();
 
 		cout << "DEBUG phaser::allelic_transform" << endl;
 		cout << "pgr addr-" << pgr << endl;
 		cout << "x2y size=" << x2y.size() << " print" << endl;
-		for(auto xypair: x2y)
+		for(int j = 0; j < x2y.size(); j++)
 		{
-			cout << "\t" << xypair.first << "\t" << xypair.second << endl;
+			cout << "\t" << sc.i2e[j] << "\t" << x2y[j] << endl;
 		}
 		cout << "finished printing x2y" << endl;
 
@@ -857,15 +858,15 @@ int phaser::allelic_transform(scallop& sc1, splice_graph* pgr, MEE& x2y)
 		}
 	}
 
-	psc->transform(pgr, sc.i2e, x2y);  // hs.transform called in sc
+	psc->transform(pgr, sc.e2i, x2y);  // hs.transform called in sc
 
 	if(DEBUG_MODE_ON)
 	{
 		psc->gr.edge_integrity_examine();
 
-		set<edge_descriptor> sc_edges;
-		set<edge_descriptor> gr_edges;
-		set<edge_descriptor> mev_edges;
+		SE sc_edges;
+		SE gr_edges;
+		SE mev_edges;
 		PEEI sc_peei = psc->gr.edges();
 		PEEI gr_peei = pgr->edges();
 		for (auto i = sc_peei.first; i != sc_peei.second; ++i) sc_edges.insert(*i);
@@ -14,7 +14,7 @@ See LICENSE for licensing.
 #include "as_pos32.hpp"
 #include "bundle.h"
 #include "scallop.h"
-#define MEPD map<edge_descriptor, pair<double, double> >
+#define MEPD map<edge_descriptor, pair<double, double>, edge_less >
 
 /*
 *   phaser takes scallop object as an input and does:
@@ -31,8 +31,12 @@ public:
 private:
     const scallop& sc;
     splice_graph& gr;
-    MED ewrt1;              // edge weight in allele1
-    MED ewrt2;              // edge weight in allele2
+    vector<int> eorder;             // indices (in sc.i2e) of edges of gr, sorted by (source, target, weight)
+    vector< vector<int> > vin;      // indices of in-edges of each vertex, following eorder
+    vector< vector<int> > vout;     // indices of out-edges of each vertex, following eorder
+    vector<double> ewrt0;   // edge weight in gr, indexed by sc.i2e
+    vector<double> ewrt1;   // edge weight in allele1, indexed by sc.i2e
+    vector<double> ewrt2;   // edge weight in allele2, indexed by sc.i2e
     vector<double> vwrt1;   // vertex weight in allele1
     vector<double> vwrt2;   // vertex weight in allele2
 
@@ -43,10 +47,8 @@ private:
     double ewrtratiobg1;   // normalized bg ratio of allele 1
     double ewrtratiobg2;   // normalized bg ratio of allele 2
 
-    MEE x2y_1;             // use x2y to map original edge to new edge, in allele 1
-	MEE y2x_1;             // use y2x to map new edge to original edge, in allele 1
-    MEE x2y_2;             // use x2y to map original edge to new edge, in allele 2
-	MEE y2x_2;             // use y2x to map new edge to original edge, in allele 2
+    VE x2y_1;              // x2y_1[i] is the new edge in allele 1 of original edge sc.i2e[i]
+    VE x2y_2;              // x2y_2[i] is the new edge in allele 2 of original edge sc.i2e[i]
 
     splice_graph* pgr1;    // pointer to sg of allele1
     splice_graph* pgr2;    // pointer to sg of allele2
@@ -67,6 +69,7 @@ private:
 
 private:
     int init();
+    int init_edge_order();
     int assemble_scallop0(scallop& sc);
     int assign_gt();
     int remove_low_depth_var_vertex();
@@ -75,16 +78,17 @@ private:
     int smooth_allelic_graphs();
     int split_hs();
     int assemble_allelic_scallop();     
-    int allelic_transform(scallop& sc, splice_graph* pgr, MEE& x2y);
+    int assemble_allele(scallop& sc, splice_graph* pgr, VE& x2y);
+    int allelic_transform(scallop& sc, splice_graph* pgr, VE& x2y);
     int assign_allele_spec_transcripts();
 
 private:
     pair<double, double> get_as_ratio(int i);
-    vector<int> sort_nodes_by_currecnt_mae(const set<int>& s);
+    int refresh_mae(int i, set< pair<double, int> >& mq, vector<double>& mae);      // update node i in the max-queue of mae
     bool split_local(int i);
     bool split_global(int i);
-    bool split_global(edge_descriptor e);
-    bool split_by_ratio(int v, const PEEI& in, const PEEI& out, double r1);                  // split edges of vertex v, by ratio 
+    bool split_global_edge(int e);
+    bool split_by_ratio(int v, double r1);                                                  // split edges of vertex v, by ratio 
     int split_by_phasing(int v, const PEEI& in, const PEEI& out, double r1);                // split edges of vertex v, by phasing path
     int split_by_min_parsimony(int v, const PEEI& in, const PEEI& out, double r1);          // split edges of vertex v, by parsimony
     pair<double, double> normalize_epsilon(double x, double y);                             // adjustment to allele ratio. new_r1 = (r1+eps) / (r1+r2+2*eps). returns<-1, -1> if both input are 0
@@ -19,10 +19,25 @@ See LICENSE for licensing.
 #include "config.h"
 // #include "gurobi_c++.h"
 
+previewer::previewer(run_config &r)
+	: rc(r)
+{}
+
 int previewer::open_file()
 {
-    sfn = sam_open(input_file.c_str(), "r");
+    sfn = sam_open(rc.input_file.c_str(), "r");
+	if(sfn == NULL)
+	{
+		printf("error: cannot open %s\n", rc.input_file.c_str());
+		return -1;
+	}
     hdr = sam_hdr_read(sfn);
+	if(hdr == NULL)
+	{
+		printf("error: cannot read the header of %s\n", rc.input_file.c_str());
+		sam_close(sfn);
+		return -1;
+	}
     b1t = bam_init1();
 	// GRBEnv env = GRBEnv(); // check Gurobi
 	return 0;
@@ -36,23 +51,22 @@ int previewer::close_file()
 	return 0;
 }
 
+// -1 if the input cannot be read or profiled; the input is checked even if nothing is to be previewed
 int previewer::preview()
 {
-	if(library_type == EMPTY)
-	{
-		open_file();
-		solve_strandness();
-		close_file();
-	}
+	if(open_file() != 0) return -1;
 
-	if(insertsize_median < 0)
+	if(rc.library_type == EMPTY)
 	{
-		open_file();
-		solve_insertsize();
+		solve_strandness();
 		close_file();
+		if(open_file() != 0) return -1;
 	}
 
-	return 0;
+	int f = 0;
+	if(rc.insertsize_median < 0) f = solve_insertsize();
+	close_file();
+	return f;
 }
 
 int previewer::solve_strandness()
@@ -67,6 +81,7 @@ int previewer::solve_strandness()
 	vector<int> sp2;
 
 	int hid = 0;
+	worker_context wc(rc);
 
     while(sam_read1(sfn, hdr, b1t) >= 0)
 	{
@@ -87,7 +102,7 @@ int previewer::solve_strandness()
 		strcpy(buf, hdr->target_name[p.tid]);
 
 		// hit ht(b1t, string(buf));
-		hit ht(b1t, string(buf), hid++);
+		hit ht(b1t, string(buf), hid++, wc);
 		ht.set_tags(b1t);
 
 		if((ht.flag & 0x1) >= 1) paired ++;
@@ -139,10 +154,10 @@ int previewer::solve_strandness()
 	if(verbose >= 1)
 	{
 		printf("preview strandness: sampled reads = %d, single = %d, paired = %d, first = %d, second = %d, inferred = %s, given = %s\n",
-			total, single, paired, first, second, vv[s1 + 1].c_str(), vv[library_type + 1].c_str());
+			total, single, paired, first, second, vv[s1 + 1].c_str(), vv[rc.library_type + 1].c_str());
 	}
 
-	if(library_type == EMPTY) library_type = s1;
+	if(rc.library_type == EMPTY) rc.library_type = s1;
 
 	return 0;
 }
@@ -156,6 +171,7 @@ int previewer::solve_insertsize()
 	bb2.strand = '-';
 	int cnt = 0;
 	int hid = 0;
+	worker_context wc(rc);
 
     while(sam_read1(sfn, hdr, b1t) >= 0)
 	{
@@ -170,10 +186,10 @@ int previewer::solve_insertsize()
 		char buf[1024];
 		strcpy(buf, hdr->target_name[p.tid]);
 
-		hit ht(b1t, string(buf), hid++);
+		hit ht(b1t, string(buf), hid++, wc);
 
 		ht.set_tags(b1t);
-		ht.set_strand();
+		ht.set_strand(rc.library_type);
 
 		// truncate
 		if(ht.tid != bb1.tid || ht.pos > bb1.rpos + min_bundle_gap)
@@ -194,15 +210,15 @@ int previewer::solve_insertsize()
 
 		// add hit
 		if(uniquely_mapped_only == true && ht.nh != 1) continue;
-		if(library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') continue;
-		if(library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') continue;
-		if(library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
-		if(library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
-		if(library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '.') bb1.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '.') bb2.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '+') bb1.add_hit(ht);
-		if(library_type == UNSTRANDED && ht.xs == '-') bb2.add_hit(ht);
+		if(rc.library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') continue;
+		if(rc.library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') continue;
+		if(rc.library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
+		if(rc.library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
+		if(rc.library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
+		if(rc.library_type == UNSTRANDED && ht.xs == '.') bb1.add_hit(ht);
+		if(rc.library_type == UNSTRANDED && ht.xs == '.') bb2.add_hit(ht);
+		if(rc.library_type == UNSTRANDED && ht.xs == '+') bb1.add_hit(ht);
+		if(rc.library_type == UNSTRANDED && ht.xs == '-') bb2.add_hit(ht);
 	}
 
 	int total = 0;
@@ -215,33 +231,33 @@ int previewer::solve_insertsize()
 	//if(total < 10000)
 	{
 		printf("not enough paired-end reads to create the profile (%d collected)\n", total);
-		exit(0);
+		return -1;
 	}
 
 	int n = 0;
-	insertsize_ave = 0;
+	rc.insertsize_ave = 0;
 	double sx2 = 0;
-	insertsize_low = -1;
-	insertsize_high = -1;
-	insertsize_median = -1;
+	rc.insertsize_low = -1;
+	rc.insertsize_high = -1;
+	rc.insertsize_median = -1;
 	for(auto it = m.begin(); it != m.end(); it++)
 	{
 		n += it->second;
-		if(n >= 0.5 * total && insertsize_median < 0) insertsize_median = it->first;
-		insertsize_ave += it->second * it->first;
+		if(n >= 0.5 * total && rc.insertsize_median < 0) rc.insertsize_median = it->first;
+		rc.insertsize_ave += it->second * it->first;
 		sx2 += it->second * it->first * it->first;
-		if(insertsize_low == -1 && n >= 1.0 * insertsize_low_percentile * total) insertsize_low = it->first;
-		if(insertsize_high == -1 && n >= 1.0 * insertsize_high_percentile * total) insertsize_high = it->first;
+		if(rc.insertsize_low == -1 && n >= 1.0 * insertsize_low_percentile * total) rc.insertsize_low = it->first;
+		if(rc.insertsize_high == -1 && n >= 1.0 * insertsize_high_percentile * total) rc.insertsize_high = it->first;
 		if(n >= 0.999 * total) break;
 	}
 	
-	insertsize_ave = insertsize_ave * 1.0 / n;
-	insertsize_std = sqrt((sx2 - n * insertsize_ave * insertsize_ave) * 1.0 / n);
+	rc.insertsize_ave = rc.insertsize_ave * 1.0 / n;
+	rc.insertsize_std = sqrt((sx2 - n * rc.insertsize_ave * rc.insertsize_ave) * 1.0 / n);
 
 	if(verbose >= 1)
 	{
 		printf("preview insertsize: sampled reads = %d, isize = %.2lf +/- %.2lf, median = %d, low = %d, high = %d\n", 
-				total, insertsize_ave, insertsize_std, insertsize_median, insertsize_low, insertsize_high);
+				total, rc.insertsize_ave, rc.insertsize_std, rc.insertsize_median, rc.insertsize_low, rc.insertsize_high);
 	}
 	
 	/*
@@ -277,7 +293,7 @@ int previewer::process_bundle(bundle_base &bb, map<int, int>& m)
 
 	bb.buildbase();
 
-	bundle_bridge br(bb);
+	bundle_bridge br(bb, rc);
 
 	br.build_junctions();
 	br.extend_junctions();
@@ -12,6 +12,7 @@ See LICENSE for licensing.
 
 #include "hit.h"
 #include "bundle_base.h"
+#include "run_context.h"
 
 #include <fstream>
 #include <string>
@@ -20,7 +21,11 @@ using namespace std;
 
 class previewer
 {
+public:
+	previewer(run_config &rc);
+
 private:
+	run_config &rc;			// library type and insert sizes are inferred into it
 	samFile *sfn;
 	bam_hdr_t *hdr;
 	bam1_t *b1t;
@@ -0,0 +1,38 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdlib>
+#include <cctype>
+
+#include "ref_window.h"
+
+ref_window::ref_window()
+	: lpos(0)
+{}
+
+bool ref_window::covers(const string &c, int32_t l, int32_t r) const
+{
+	return c == chrm && l >= lpos && r <= lpos + (int32_t)(seq.size());
+}
+
+int ref_window::fetch(faidx_t *fai, const string &c, int32_t l, int32_t r)
+{
+	if(covers(c, l, r)) return 0;
+
+	chrm = c;
+	lpos = l;
+	seq = "";
+	if(fai == NULL || l >= r) return 0;
+
+	int len = 0;
+	char *x = faidx_fetch_seq(fai, c.c_str(), l, r - 1, &len);		// both ends included
+	if(x == NULL) return 0;
+
+	seq.assign(x, len);
+	free(x);
+	for(int i = 0; i < seq.size(); i++) seq[i] = toupper(seq[i]);
+	return 0;
+}
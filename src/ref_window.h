@@ -0,0 +1,33 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __REF_WINDOW_H__
+#define __REF_WINDOW_H__
+
+#include <string>
+#include <stdint.h>
+
+#include "htslib/faidx.h"
+
+using namespace std;
+
+// the reference of one window (e.g., a bundle), fetched once from the fasta index and shared by its transcripts
+class ref_window
+{
+public:
+	ref_window();
+
+public:
+	string chrm;
+	int32_t lpos;			// 0-based position of seq[0]
+	string seq;				// upper case
+
+public:
+	int fetch(faidx_t *fai, const string &chrm, int32_t l, int32_t r);		// [l, r), reuses the window if it covers it
+	bool covers(const string &chrm, int32_t l, int32_t r) const;
+};
+
+#endif
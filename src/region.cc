@@ -28,35 +28,37 @@ region::region(as_pos32 _lpos, as_pos32 _rpos, int _ltype, int _rtype, genotype
 	ave = 0;
 	max = 0;
 	dev = 1;
-	build_join_interval_map();
+	SIMI hint = locate_right_iterator(*mmap, as_pos32(lpos.p32, "$"));
+	build_join_interval_map(*mmap, hint);
 	smooth_join_interval_map();
-	build_partial_exons();
+	build_partial_exons(*mmap, hint);
 }
 
 region::~region()
 {}
 
-int region::rebuild(const split_interval_map *_mmap)
+// hint walks fmap along with the regions, see locate_boundary_iterators
+int region::rebuild(const flat_interval_map &fmap, FIMI &hint)
 {
 	if (is_allelic()) throw runtime_error("Should not re-build allelic region for allelic partial-exon!");
-	mmap = _mmap; 
-	build_join_interval_map();
+	build_join_interval_map(fmap, hint);
 	smooth_join_interval_map();
-	build_partial_exons();
+	build_partial_exons(fmap, hint);
 	return 0;
 }
 
 
-int region::build_join_interval_map()
+template<class M>
+int region::build_join_interval_map(const M &m, typename M::const_iterator &hint)
 {
 	jmap.clear();
 
-	PSIMI pei = locate_boundary_iterators(*mmap, as_pos32(lpos.p32, "$"), as_pos32(rpos.p32, "$"));
-	SIMI lit = pei.first, rit = pei.second;
+	pair<typename M::const_iterator, typename M::const_iterator> pei = locate_boundary_iterators(m, hint, as_pos32(lpos.p32, "$"), as_pos32(rpos.p32, "$"));
+	typename M::const_iterator lit = pei.first, rit = pei.second;
 
-	if(lit == mmap->end() || rit == mmap->end()) return 0;
+	if(lit == m.end() || rit == m.end()) return 0;
 
-	SIMI it = lit;
+	typename M::const_iterator it = lit;
 	while(true)
 	{
 		jmap += make_pair(it->first, 1);
@@ -109,31 +111,28 @@ int region::smooth_join_interval_map()
 	return 0;
 }
 
-bool region::empty_subregion(as_pos32 p1, as_pos32 p2)
+// pe holds the coverage of [p1, p2) from evaluate_rectangle, covered is false if it found no interval
+bool region::empty_subregion(as_pos32 p1, as_pos32 p2, bool covered, const partial_exon &pe)
 {
 	assert(p1 < p2);
 	assert(p1 >= lpos && p2 <= rpos);
 
 	//printf(" region = [%d, %d), subregion [%d, %d), length = %d\n", lpos, rpos, p1, p2, p2 - p1);
 	if(p2 - p1 < min_subregion_len) return true;
+	if(covered == false) return true;
 
-	PSIMI pei = locate_boundary_iterators(*mmap, p1, p2);
-	SIMI it1 = pei.first, it2 = pei.second;
-	if(it1 == mmap->end() || it2 == mmap->end()) return true;
-
-	int32_t sum = compute_sum_overlap(*mmap, it1, it2);
-	int32_t max = compute_max_overlap(*mmap, it1, it2);
-	double ratio = sum * 1.0 / double(p2 - p1);
+	double ratio = pe.ave;
 	//printf(" region = [%d, %d), subregion [%d, %d), overlap = %.2lf\n", lpos, rpos, p1, p2, ratio);
 	//if(ratio < min_subregion_overlap + max_intron_contamination_coverage) return true;
 	if(ratio < min_subregion_ave) return true;
-	if(max < min_subregion_max) return true;
+	if(pe.max < min_subregion_max) return true;
 
 
 	return false;
 }
 
-int region::build_partial_exons()
+template<class M>
+int region::build_partial_exons(const M &m, typename M::const_iterator &hint)
 {
 	pexons.clear();
 
@@ -146,7 +145,7 @@ int region::build_partial_exons()
 		partial_exon pe(lpos, rpos, ltype, rtype, gt);
 		if(! is_allelic()) 
 		{
-			evaluate_rectangle(*mmap, pe.lpos, pe.rpos, pe.ave, pe.dev, pe.max);
+			evaluate_rectangle(m, hint, pe.lpos, pe.rpos, pe.ave, pe.dev, pe.max);
 		}
 		else
 		{
@@ -192,9 +191,9 @@ int region::build_partial_exons()
 
 		if (! is_allelic())
 		{
-			evaluate_rectangle(*mmap, pe.lpos, pe.rpos, pe.ave, pe.dev, pe.max);
+			int c = evaluate_rectangle(m, hint, pe.lpos, pe.rpos, pe.ave, pe.dev, pe.max);
 	
-			b = empty_subregion(p1, p2);
+			b = empty_subregion(p1, p2, c == 0, pe);
 			if(p1.samepos(lpos) && ( (ltype & RIGHT_SPLICE) > 0 || (ltype & ALLELIC_RIGHT_SPLICE) > 0) )b = false;
 			if(p2.samepos(rpos) && ( (rtype & LEFT_SPLICE ) > 0 || (rtype & ALLELIC_LEFT_SPLICE ) > 0) )b = false;
 		}
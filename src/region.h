@@ -43,17 +43,17 @@ public:
 	vector<partial_exon> pexons;	// generated partial exons
 
 public:
-	int rebuild(const split_interval_map *_mmap);
+	int rebuild(const flat_interval_map &fmap, FIMI &hint);
 	int print(int index) const;
 	bool is_allelic() const;
 	int assign_as_cov(double _ave, double _dev, double _max);
 	bool operator<(const region &x) const;
 
 private:
-	int build_join_interval_map();
+	template<class M> int build_join_interval_map(const M &m, typename M::const_iterator &hint);
 	int smooth_join_interval_map();
-	bool empty_subregion(as_pos32 p1, as_pos32 p2);
-	int build_partial_exons();
+	bool empty_subregion(as_pos32 p1, as_pos32 p2, bool covered, const partial_exon &pe);
+	template<class M> int build_partial_exons(const M &m, typename M::const_iterator &hint);
 };
 
 #endif
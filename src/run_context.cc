@@ -0,0 +1,42 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include "run_context.h"
+#include "config.h"
+
+run_config::run_config()
+{
+	input_file = ::input_file;
+	output_file = ::output_file;
+	output_file1 = ::output_file1;
+	vcf = (vcf_file == "") ? NULL : &asp;
+	fasta_file = fasta_input;
+	library_type = ::library_type;
+	insertsize_ave = ::insertsize_ave;
+	insertsize_std = ::insertsize_std;
+	insertsize_median = ::insertsize_median;
+	insertsize_low = ::insertsize_low;
+	insertsize_high = ::insertsize_high;
+}
+
+worker_context::worker_context(const run_config &r)
+	: rc(r), fai(NULL), fai_loaded(false)
+{}
+
+worker_context::~worker_context()
+{
+	if(fai != NULL) fai_destroy(fai);
+}
+
+int worker_context::fetch_reference(ref_window &w, const string &chrm, int32_t l, int32_t r)
+{
+	lock_guard<mutex> lock(fai_mtx);
+	if(fai_loaded == false && rc.fasta_file != "") fai = fai_load(rc.fasta_file.c_str());
+	fai_loaded = true;
+	if(fai == NULL) return -1;
+	w.fetch(fai, chrm, l, r);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __RUN_CONTEXT_H__
+#define __RUN_CONTEXT_H__
+
+#include <string>
+#include <mutex>
+#include <stdint.h>
+
+#include "htslib/faidx.h"
+#include "vcf_data.h"
+#include "ref_window.h"
+
+using namespace std;
+
+/*
+** the inputs of a run (of one sample, with --batch) that are not plain parameters: the files, the variants,
+** and the library type and insert sizes, as given or inferred by previewer (or restored from a capture file);
+** filled before the bundles are assembled and only read afterwards, so workers share it without locking
+*/
+class run_config
+{
+public:
+	run_config();			// from the parsed arguments
+
+public:
+	string input_file;		// bam
+	string output_file;		// output prefix
+	string output_file1;	// prefix of non-full-length transcripts, -f
+	const vcf_data *vcf;	// NULL without vcf
+	string fasta_file;		// -G, empty if not given
+	int library_type;
+	double insertsize_ave;
+	double insertsize_std;
+	int insertsize_median;
+	int insertsize_low;
+	int insertsize_high;
+};
+
+/*
+** mutable state of one worker that reads or assembles bundles, owned by its thread;
+** the random orderings of scallop are seeded per task (see task_seed), not kept here,
+** so that the transcripts do not depend on which worker assembles a bundle
+*/
+class worker_context
+{
+public:
+	worker_context(const run_config &rc);
+	~worker_context();
+
+private:
+	worker_context(const worker_context &wc);	// owns fai
+
+public:
+	const run_config &rc;
+	variant_cursor vc;		// variants of the hits being read
+
+private:
+	faidx_t *fai;			// own index, loaded by the first fetch
+	bool fai_loaded;
+	mutex fai_mtx;			// fetching is not thread-safe; the alleles are written in their own threads
+
+public:
+	int fetch_reference(ref_window &w, const string &chrm, int32_t l, int32_t r);		// [l, r) into w; -1 without reference
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+
+#include "run_stats.h"
+#include "config.h"
+#include "util.h"
+
+run_stats rstats;
+
+static const char *stage_names[NUM_STAGES] = {"read", "buildbase", "bundle_bridge", "bridger", "bundle", "super_graph",
+	"scallop", "phaser", "merge", "write"};
+static const char *count_names[NUM_COUNTS] = {"reads", "bundles", "hits", "fragments", "graphs", "transcripts"};
+
+// allocations are counted per thread, so a stage sees only its own
+static thread_local uint64_t alloc_count = 0;
+
+run_stats::run_stats()
+	: calls(NUM_STAGES, 0), seconds(NUM_STAGES, 0), allocs(NUM_STAGES, 0), rss(NUM_STAGES, 0), running(NUM_STAGES, 0),
+	max_rss(0), resettable(true), counts(NUM_COUNTS, 0)
+{
+	t0 = wall_clock();
+}
+
+uint64_t run_stats::num_allocations()
+{
+	return alloc_count;
+}
+
+int run_stats::count_allocation()
+{
+	alloc_count++;
+	return 0;
+}
+
+int run_stats::add_allocations(uint64_t n)
+{
+	alloc_count += n;
+	return 0;
+}
+
+long run_stats::peak_rss()
+{
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+	return ru.ru_maxrss;
+}
+
+// VmHWM of /proc/self/status, getrusage where it is missing; with reset, the mark is lowered to the current RSS
+// so that the next reading is the peak since now; without /proc/self/clear_refs a stage sees the peak so far
+long run_stats::mark_rss(bool reset)
+{
+	long h = -1;
+	FILE *f = fopen("/proc/self/status", "r");
+	if(f != NULL)
+	{
+		char line[256];
+		while(fgets(line, sizeof(line), f) != NULL)
+		{
+			if(strncmp(line, "VmHWM:", 6) == 0) h = atol(line + 6);
+		}
+		fclose(f);
+	}
+	if(h < 0) h = peak_rss();
+
+	for(int i = 0; i < NUM_STAGES; i++) if(running[i] >= 1 && h > rss[i]) rss[i] = h;
+	if(h > max_rss) max_rss = h;
+
+	if(reset && resettable)
+	{
+		f = fopen("/proc/self/clear_refs", "w");
+		if(f == NULL || fputs("5", f) < 0) resettable = false;
+		if(f != NULL && fclose(f) != 0) resettable = false;
+	}
+	return h;
+}
+
+// the memory of a stage is only followed for --stats-json, reading /proc on every call is not free
+int run_stats::enter(int stage)
+{
+	if(stats_json_file == "") return 0;
+	lock_guard<mutex> lock(mtx);
+	mark_rss(true);
+	running[stage]++;
+	return 0;
+}
+
+int run_stats::add(int stage, double s, uint64_t a)
+{
+	lock_guard<mutex> lock(mtx);
+	calls[stage]++;
+	seconds[stage] += s;
+	allocs[stage] += a;
+	if(running[stage] >= 1)
+	{
+		mark_rss(false);
+		running[stage]--;
+	}
+	return 0;
+}
+
+int run_stats::count(int counter, long n)
+{
+	lock_guard<mutex> lock(mtx);
+	counts[counter] += n;
+	return 0;
+}
+
+int run_stats::write(const string &file)
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if(f == NULL)
+	{
+		fprintf(stderr, "cannot open %s to write run statistics\n", file.c_str());
+		return -1;
+	}
+
+	lock_guard<mutex> lock(mtx);
+	fprintf(f, "{\n");
+	fprintf(f, "  \"version\": \"%s\",\n", version.c_str());
+	fprintf(f, "  \"num_threads\": %d,\n", num_threads);
+	fprintf(f, "  \"wall_seconds\": %.6lf,\n", wall_clock() - t0);
+	mark_rss(false);
+	fprintf(f, "  \"peak_rss_kb\": %ld,\n", max(max_rss, peak_rss()));
+	fprintf(f, "  \"stages\": {\n");
+	for(int i = 0; i < NUM_STAGES; i++)
+	{
+		fprintf(f, "    \"%s\": {\"calls\": %ld, \"seconds\": %.6lf, \"allocations\": %llu, \"peak_rss_kb\": %ld}%s\n",
+				stage_names[i], calls[i], seconds[i], (unsigned long long)allocs[i], rss[i], i + 1 < NUM_STAGES ? "," : "");
+	}
+	fprintf(f, "  },\n");
+	fprintf(f, "  \"counts\": {\n");
+	for(int i = 0; i < NUM_COUNTS; i++)
+	{
+		fprintf(f, "    \"%s\": %ld%s\n", count_names[i], counts[i], i + 1 < NUM_COUNTS ? "," : "");
+	}
+	fprintf(f, "  }\n");
+	fprintf(f, "}\n");
+	fclose(f);
+	return 0;
+}
+
+stage_timer::stage_timer(int s)
+	: stage(s), running(false)
+{
+	start();
+}
+
+stage_timer::~stage_timer()
+{
+	stop();
+}
+
+int stage_timer::start()
+{
+	if(running) return 0;
+	running = true;
+	rstats.enter(stage);
+	t = wall_clock();
+	a = run_stats::num_allocations();
+	return 0;
+}
+
+int stage_timer::stop()
+{
+	if(!running) return 0;
+	running = false;
+	rstats.add(stage, wall_clock() - t, run_stats::num_allocations() - a);
+	return 0;
+}
+
+stage_thread::~stage_thread()
+{
+	if(t.joinable()) t.join();
+}
+
+int stage_thread::run(function<void()> g)
+{
+	uint64_t a = run_stats::num_allocations();
+	try
+	{
+		g();
+	}
+	catch(...)
+	{
+		e = current_exception();
+	}
+	n = run_stats::num_allocations() - a;
+	return 0;
+}
+
+int stage_thread::join()
+{
+	t.join();
+	run_stats::add_allocations(n);
+	if(e) rethrow_exception(e);
+	return 0;
+}
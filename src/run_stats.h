@@ -0,0 +1,108 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __RUN_STATS_H__
+#define __RUN_STATS_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <stdint.h>
+
+using namespace std;
+
+// stages timed by stage_timer; stages may nest (e.g., scallop inside phaser), so times are inclusive
+enum { STAGE_READ = 0, STAGE_BUILDBASE, STAGE_BUNDLE_BRIDGE, STAGE_BRIDGER, STAGE_BUNDLE, STAGE_SUPER_GRAPH,
+	STAGE_SCALLOP, STAGE_PHASER, STAGE_MERGE, STAGE_WRITE, NUM_STAGES };
+
+// counters
+enum { COUNT_READS = 0, COUNT_BUNDLES, COUNT_HITS, COUNT_FRAGMENTS, COUNT_GRAPHS, COUNT_TRANSCRIPTS, NUM_COUNTS };
+
+/*
+**	run_stats accumulates, per stage, the number of calls, wall-clock seconds and allocations
+**	(made by the thread running the stage and the stage_threads it joined), and the peak RSS of
+**	the process while a call of the stage ran; the report is written as JSON by write()
+*/
+class run_stats
+{
+public:
+	run_stats();
+
+public:
+	int enter(int stage);
+	int add(int stage, double seconds, uint64_t allocs);		// when a call of stage returns
+	int count(int counter, long n);
+	int write(const string &file);
+
+	static uint64_t num_allocations();			// number of operator new calls of the calling thread, 0 without alloc_count.cc
+	static int count_allocation();				// called by the operator new of alloc_count.cc
+	static int add_allocations(uint64_t n);		// credit n allocations of a joined worker to the calling thread
+	static long peak_rss();						// peak resident set size of the process, in KB
+
+private:
+	mutex mtx;
+	double t0;
+	vector<long> calls;
+	vector<double> seconds;
+	vector<uint64_t> allocs;
+	vector<long> rss;			// peak RSS, in KB, seen while a call of the stage ran
+	vector<int> running;		// calls in progress, per stage
+	long max_rss;				// peak RSS of the process, across the resets
+	bool resettable;			// /proc/self/clear_refs accepts resetting the high-water mark
+	vector<long> counts;
+
+private:
+	long mark_rss(bool reset);	// credit the high-water mark to the running stages, and reset it
+};
+
+// times one stage from construction (or start) to destruction (or stop)
+class stage_timer
+{
+public:
+	stage_timer(int stage);
+	~stage_timer();
+
+public:
+	int start();
+	int stop();
+
+private:
+	int stage;
+	bool running;
+	double t;
+	uint64_t a;
+};
+
+// a thread whose allocations are credited to the stages running in the thread that joins it;
+// join rethrows what the thread threw, the destructor joins a thread left running by an exception of the caller
+class stage_thread
+{
+public:
+	template<class F, class... A> stage_thread(F f, A... a);
+	~stage_thread();
+
+public:
+	int join();
+
+private:
+	int run(function<void()> g);
+
+private:
+	uint64_t n;
+	exception_ptr e;
+	thread t;
+};
+
+template<class F, class... A> stage_thread::stage_thread(F f, A... a)
+	: n(0), t(&stage_thread::run, this, function<void()>(bind(f, a...)))
+{}
+
+extern run_stats rstats;
+
+#endif
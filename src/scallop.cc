@@ -10,6 +10,8 @@ See LICENSE for licensing.
 
 #include "scallop.h"
 #include "config.h"
+#include "util.h"
+#include "run_stats.h"
 
 #include <cstdio>
 #include <iostream>
@@ -22,10 +24,12 @@ See LICENSE for licensing.
 ** re-use v2v
 ** transform mev, hs
 ** rebuild e2i, i2e
+** each allele draws its own rng stream, so sc1 and sc2 may be assembled concurrently
 */
-scallop::scallop(splice_graph *g, const hyper_set &_hs, const scallop &sc, bool r, bool keep_as)
-	: gr(*g), hs(_hs), random_ordering(r), keep_as_nodes(false)
+scallop::scallop(splice_graph *g, const hyper_set &_hs, const scallop &sc, int allele, bool r, bool keep_as)
+	: gr(*g), hs(_hs), random_ordering(r), keep_as_nodes(false), greedy_only(sc.greedy_only), deadline(sc.deadline)
 {
+	set_seed(task_seed(sc.seed, allele));
 	assert(!keep_as);
 	assert(!keep_as_nodes);
 	round = 0;
@@ -40,7 +44,8 @@ scallop::scallop(splice_graph *g, const hyper_set &_hs, const scallop &sc, bool
 
 
 // transform mev, hs
-int scallop::transform(splice_graph* pgr, const VE& i2e_old, const MEE& x2y)
+// x2y is indexed by original edge index, i.e., x2y[e2i_old[e]] is the new edge of e
+int scallop::transform(splice_graph* pgr, const MEI& e2i_old, const VE& x2y)
 {
 	MEV mev2;
 	for(auto i: mev)
@@ -50,9 +55,11 @@ int scallop::transform(splice_graph* pgr, const VE& i2e_old, const MEE& x2y)
 		if (e1 == null_edge) continue;
 
 		// transform edge
-		auto e2_iterator = x2y.find(e1);
-		assert(e2_iterator != x2y.end()); 
-		edge_descriptor e2 = e2_iterator->second;
+		auto e1_iterator = e2i_old.find(e1);
+		assert(e1_iterator != e2i_old.end()); 
+		assert(e1_iterator->second >= 0 && e1_iterator->second < x2y.size());
+		edge_descriptor e2 = x2y[e1_iterator->second];
+		assert(e2 != null_edge);
 		assert(e2 != e1);
 		
 		// add edge
@@ -61,7 +68,7 @@ int scallop::transform(splice_graph* pgr, const VE& i2e_old, const MEE& x2y)
 	}
 	mev = mev2;
 
-	hs.transform(pgr, i2e_old, x2y, e2i);
+	hs.transform(pgr, x2y, e2i);
 	hs.build_index();
 
 	if(DEBUG_MODE_ON && print_scallop_detail) {cout <<"hs transformed" << endl; hs.print();}
@@ -69,6 +76,13 @@ int scallop::transform(splice_graph* pgr, const VE& i2e_old, const MEE& x2y)
 	return 0;
 }
 
+int scallop::set_seed(uint64_t s)
+{
+	seed = s;
+	rng.seed(s);
+	return 0;
+}
+
 /*
 ** after scallop.assemble() is paused
 ** continue to assemble everything (incld. as and non-as transcripts)
@@ -92,8 +106,9 @@ int scallop::assemble_continue(bool is_allelic)
 **	sc0 w. both alleles
 */ 
 scallop::scallop(splice_graph &g, const hyper_set &h, bool r, bool _keep)
-	: gr(g), hs(h), random_ordering(r), keep_as_nodes(_keep)
+	: gr(g), hs(h), random_ordering(r), keep_as_nodes(_keep), greedy_only(false), deadline(0)
 {
+	set_seed(random_seed);
 	//TODO? traverse and assign node phasing info if it is determined -- in init stage
 	round = 0;
 	gr.get_edge_indices(i2e, e2i);
@@ -112,6 +127,7 @@ scallop::~scallop()
 
 int scallop::assemble(bool is_allelic)
 {
+	stage_timer st(STAGE_SCALLOP);
 	int c = classify();
 	
 	if(verbose >= 1)
@@ -140,6 +156,11 @@ int scallop::assemble(bool is_allelic)
 	while(true)
 	{	
 		if(gr.num_vertices() > max_num_exons) break;
+		if(!greedy_only && deadline > 0 && wall_clock() > deadline)
+		{
+			if(verbose >= 1) printf("time budget exceeded in %s, use greedy decomposition\n", gr.gid.c_str());
+			greedy_only = true;
+		}
 
 		bool b = false;
 
@@ -147,6 +168,9 @@ int scallop::assemble(bool is_allelic)
 		if(!assert_debug()) cerr << "assert debug failed 1" << endl;
 		if(b == true) continue;
 
+		// over budget: only trivial vertices (linear time) are resolved before greedy_decompose
+		if(greedy_only) break;
+
 		b = resolve_trivial_vertex(1, max_decompose_error_ratio[TRIVIAL_VERTEX]);
 		if(!assert_debug()) cerr << "assert debug failed 2" << endl;
 		if(b == true) continue;
@@ -266,7 +290,7 @@ bool scallop::resolve_smallest_edges(double max_ratio)
 	double ratio = max_ratio;
 	bool flag = false;
 	vector<int> vv(nsnonzeroset.begin(), nsnonzeroset.end());
-	if(random_ordering) random_shuffle(vv.begin(), vv.end());
+	if(random_ordering) shuffle(vv.begin(), vv.end(), rng);
 
 	for(int k = 0; k < vv.size(); k++)
 	{
@@ -388,7 +412,7 @@ bool scallop::resolve_splittable_vertex(int type, int degree, double max_ratio)
 	double ratio = max_ratio;
 	vector<equation> eqns;
 	vector<int> vv(nsnonzeroset.begin(), nsnonzeroset.end());
-	if(random_ordering) random_shuffle(vv.begin(), vv.end());
+	if(random_ordering) shuffle(vv.begin(), vv.end(), rng);
 
 	for(int k = 0; k < vv.size(); k++)
 	{
@@ -438,7 +462,7 @@ bool scallop::resolve_unsplittable_vertex(int type, int degree, double max_ratio
 	double ratio = max_ratio;
 	bool flag = false;
 	vector<int> vv(nsnonzeroset.begin(), nsnonzeroset.end());
-	if(random_ordering) random_shuffle(vv.begin(), vv.end());
+	if(random_ordering) shuffle(vv.begin(), vv.end(), rng);
 
 	for(int k = 0; k < vv.size(); k++)
 	{
@@ -586,7 +610,7 @@ bool scallop::resolve_trivial_vertex(int type, double jump_ratio)
 	// int se = -1;
 	bool flag = false;
 	vector<int> vv(nsnonzeroset.begin(), nsnonzeroset.end());
-	if(random_ordering) random_shuffle(vv.begin(), vv.end());
+	if(random_ordering) shuffle(vv.begin(), vv.end(), rng);
 
 	for(int k = 0; k < vv.size(); k++)
 	{
@@ -638,7 +662,7 @@ bool scallop::resolve_trivial_vertex_fast(double jump_ratio)
 {
 	bool flag = false;
 	vector<int> vv(nsnonzeroset.begin(), nsnonzeroset.end());
-	if(random_ordering) random_shuffle(vv.begin(), vv.end());
+	if(random_ordering) shuffle(vv.begin(), vv.end(), rng);
 
 	for(int k = 0; k < vv.size(); k++)
 	{
@@ -1621,8 +1645,8 @@ bool scallop::assert_mev_gr_edge_descriptor_bijection()
 	size_t i = mev.size();
 	size_t j = gr.num_edges();
 	
-	set<edge_descriptor> mev_edges;
-	set<edge_descriptor> gr_edges;
+	SE mev_edges;
+	SE gr_edges;
 	
 	PEEI gr_peei = gr.edges();
 	for (auto j = gr_peei.first; j != gr_peei.second; ++j) gr_edges.insert(*j);
@@ -1643,8 +1667,8 @@ bool scallop::assert_mev_super_set_gr_edge_descriptor()
 	size_t i = mev.size();
 	size_t j = gr.num_edges();
 	
-	set<edge_descriptor> mev_edges;
-	set<edge_descriptor> gr_edges;
+	SE mev_edges;
+	SE gr_edges;
 	
 	PEEI gr_peei = gr.edges();
 	for (auto j = gr_peei.first; j != gr_peei.second; ++j) gr_edges.insert(*j);
@@ -11,6 +11,8 @@ See LICENSE for licensing.
 #ifndef __SCALLOP3_H__
 #define __SCALLOP3_H__
 
+#include <random>
+
 #include "splice_graph.h"
 #include "hyper_set.h"
 #include "equation.h"
@@ -18,7 +20,7 @@ See LICENSE for licensing.
 #include "path.h"
 #include "transcript.h"
 
-typedef map< edge_descriptor, vector<int> > MEV;
+typedef map< edge_descriptor, vector<int>, edge_less > MEV;
 typedef pair< edge_descriptor, vector<int> > PEV;
 typedef pair< vector<int>, vector<int> > PVV;
 typedef pair<PEE, int> PPEEI;
@@ -31,24 +33,29 @@ class scallop
 {
 public:
 	scallop(splice_graph &gr, const hyper_set &hs, bool r = false, bool keep_as = true);                      // sc w. both alleles 
-	scallop(splice_graph* gr, const hyper_set &hs, const scallop &sc, bool r = false, bool keep_as = false);  // sc for each allele
+	scallop(splice_graph* gr, const hyper_set &hs, const scallop &sc, int allele, bool r = false, bool keep_as = false);  // sc for each allele
 	virtual ~scallop();
 
 public:
 	int assemble(bool is_allelic);
 	int assemble_continue(bool is_allelic);
-	int transform(splice_graph* pgr, const VE& old_i2e, const MEE& x2y);  // allelic transform
+	int transform(splice_graph* pgr, const MEI& old_e2i, const VE& x2y);  // allelic transform
+	int set_seed(uint64_t s);			// restart rng; see task_seed
 
 public:
 	splice_graph& gr;					// splice graph
 	MEI e2i;							// edge map, from edge to index
 	VE i2e;								// edge map, from index to edge
 	bool random_ordering;				// whether using random ordering
+	uint64_t seed;						// seed of rng, which orders vertices if random_ordering
+	mt19937_64 rng;
 	MEV mev;							// super edges
 	vector<int> v2v;					// vertex map
 	hyper_set hs;						// hyper edges
 	int round;							// iteration
 	bool keep_as_nodes;					// true: decompose ns nodes only, false: decompose all nodes
+	bool greedy_only;					// true: skip iterative decomposition, use greedy_decompose only
+	double deadline;					// wall-clock time after which greedy_only is set, 0: no limit
 
 	set<int> asnonzeroset;			    // vertices with degree >= 1 && !vi.is_ordinary_vertex()
 	set<int> nsnonzeroset;				// vertices with degree >= 1 &&  vi.is_ordinary_vertex()
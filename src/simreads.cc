@@ -0,0 +1,501 @@
+/*
+Part of Altai
+(c) 2022 by Xiaofei Carl Zang, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+/*
+**	altai_simreads: simulate paired-end RNA-seq alignments from transcript models (GTF) and a phased VCF;
+**	each fragment is drawn from one haplotype, so reads carry the alleles of that haplotype at every SNP;
+**	the output is a coordinate-sorted and indexed BAM, identical for identical input, options and seed
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+
+#include "htslib/sam.h"
+#include "htslib/faidx.h"
+#include "item.h"
+#include "transcript.h"
+#include "util.h"
+
+using namespace std;
+
+// options
+static string gtf_file = "";
+static string vcf_in = "";
+static string fasta_file = "";
+static string bam_file = "";
+static double depth = 30;				// mean per-base coverage of each transcript
+static double allele_ratio = 0.5;		// fraction of fragments from haplotype 1
+static int read_length = 100;
+static double insert_mean = 250;
+static double insert_sd = 50;
+static bool wasp_tags = false;			// write vW tags on reads overlapping SNPs
+static double wasp_fail = 0;			// fraction of those reads failing WASP (vW > 1)
+static int chrm_pad = 1000;				// bases after the last exon when no reference is given
+static unsigned long seed = 42;
+
+// one simulated fragment, reads are regenerated from it when written
+class sim_frag
+{
+public:
+	int t;					// transcript index
+	int32_t s;				// start on the spliced transcript
+	int32_t f;				// fragment length
+	int8_t hap;				// 0 or 1
+	int8_t first;			// which mate is read 1: 0 leftmost, 1 rightmost
+	int8_t vw;				// vW tag of both mates, 0: none
+};
+
+// one read: the left (mate = 0) or the right (mate = 1) end of a fragment
+class sim_read
+{
+public:
+	int32_t pos;
+	int32_t frag;
+	int8_t mate;
+
+public:
+	bool operator<(const sim_read &r) const
+	{
+		if(pos != r.pos) return pos < r.pos;
+		if(frag != r.frag) return frag < r.frag;
+		return mate < r.mate;
+	}
+};
+
+// a chromosome with its reference bases, haplotype SNPs and transcripts
+class sim_chrm
+{
+public:
+	string name;
+	int32_t len;
+	string ref;
+	map<int32_t, char> alleles[2];		// SNP bases of each haplotype
+	vector<transcript> trsts;
+};
+
+static int print_simreads_help()
+{
+	printf("usage: altai_simreads -g <models.gtf> -v <phased.vcf> -o <output.bam> [options]\n");
+	printf(" %-42s  %s\n", "-g <filename>",  "transcript models to sample reads from, GTF");
+	printf(" %-42s  %s\n", "-v <filename>",  "phased variants, VCF; only single-base substitutions are used");
+	printf(" %-42s  %s\n", "-o <filename>",  "output BAM, coordinate-sorted and indexed");
+	printf(" %-42s  %s\n", "-G <filename>",  "reference genome, FASTA; random bases seeded by --seed if not given");
+	printf(" %-42s  %s\n", "--depth <float>",  "mean coverage of each transcript, default: 30");
+	printf(" %-42s  %s\n", "--allele_ratio <float>",  "fraction of fragments from the first haplotype, default: 0.5");
+	printf(" %-42s  %s\n", "--read_length <integer>",  "length of each mate, default: 100");
+	printf(" %-42s  %s\n", "--insert_mean <float>",  "mean fragment length, default: 250");
+	printf(" %-42s  %s\n", "--insert_sd <float>",  "standard deviation of fragment length, default: 50");
+	printf(" %-42s  %s\n", "--wasp",  "write vW tags on reads overlapping variants, as STAR --waspOutputMode");
+	printf(" %-42s  %s\n", "--wasp_fail <float>",  "fraction of those reads failing WASP filtering, default: 0");
+	printf(" %-42s  %s\n", "--seed <integer>",  "seed of the simulation, default: 42");
+	return 0;
+}
+
+static int parse_simreads_arguments(int argc, const char **argv)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		string a = argv[i];
+		if(a == "--wasp") { wasp_tags = true; continue; }
+		if(i + 1 >= argc) return -1;
+		string v = argv[++i];
+		if(a == "-g") gtf_file = v;
+		else if(a == "-v") vcf_in = v;
+		else if(a == "-G") fasta_file = v;
+		else if(a == "-o") bam_file = v;
+		else if(a == "--depth") depth = atof(v.c_str());
+		else if(a == "--allele_ratio") allele_ratio = atof(v.c_str());
+		else if(a == "--read_length") read_length = atoi(v.c_str());
+		else if(a == "--insert_mean") insert_mean = atof(v.c_str());
+		else if(a == "--insert_sd") insert_sd = atof(v.c_str());
+		else if(a == "--wasp_fail") wasp_fail = atof(v.c_str());
+		else if(a == "--seed") seed = strtoul(v.c_str(), NULL, 10);
+		else return -1;
+	}
+	if(gtf_file == "" || vcf_in == "" || bam_file == "") return -1;
+	if(read_length <= 0 || depth < 0 || allele_ratio < 0 || allele_ratio > 1) return -1;
+	return 0;
+}
+
+// exons of the GTF grouped into transcripts, and transcripts into chromosomes, in order of first appearance
+static int load_transcripts(vector<sim_chrm> &chrms)
+{
+	ifstream fin(gtf_file.c_str());
+	if(fin.fail())
+	{
+		fprintf(stderr, "cannot open transcript models %s\n", gtf_file.c_str());
+		return -1;
+	}
+
+	vector<transcript> v;
+	map<string, int> t2i;
+	string line;
+	while(getline(fin, line))
+	{
+		if(line.size() == 0 || line[0] == '#') continue;
+		item ge(line);
+		if(ge.feature != "exon") continue;
+		if(t2i.find(ge.transcript_id) == t2i.end())
+		{
+			t2i.insert(pair<string, int>(ge.transcript_id, v.size()));
+			v.push_back(transcript());
+			v.back().seqname = ge.seqname;
+			v.back().transcript_id = ge.transcript_id;
+			v.back().strand = ge.strand;
+		}
+		v[t2i[ge.transcript_id]].add_exon(as_pos32(ge.start.p32, "$"), as_pos32(ge.end.p32, "$"));
+	}
+
+	map<string, int> c2i;
+	for(int i = 0; i < v.size(); i++)
+	{
+		transcript &t = v[i];
+		t.sort();
+		if(c2i.find(t.seqname) == c2i.end())
+		{
+			c2i.insert(pair<string, int>(t.seqname, chrms.size()));
+			chrms.push_back(sim_chrm());
+			chrms.back().name = t.seqname;
+			chrms.back().len = 0;
+		}
+		sim_chrm &c = chrms[c2i[t.seqname]];
+		c.trsts.push_back(t);
+		if(t.exons.back().second.p32 > c.len) c.len = t.exons.back().second.p32;
+	}
+	return 0;
+}
+
+// reference bases from the FASTA, or random bases seeded per chromosome
+static int load_reference(vector<sim_chrm> &chrms)
+{
+	faidx_t *fx = NULL;
+	if(fasta_file != "") fx = fai_load(fasta_file.c_str());
+	if(fasta_file != "" && fx == NULL)
+	{
+		fprintf(stderr, "cannot load reference %s\n", fasta_file.c_str());
+		return -1;
+	}
+
+	for(int i = 0; i < chrms.size(); i++)
+	{
+		sim_chrm &c = chrms[i];
+		if(fx != NULL && faidx_has_seq(fx, c.name.c_str()))
+		{
+			c.len = faidx_seq_len(fx, c.name.c_str());
+			int n = 0;
+			char *s = faidx_fetch_seq(fx, c.name.c_str(), 0, c.len - 1, &n);
+			c.ref = string(s, n > 0 ? n : 0);
+			free(s);
+			for(int k = 0; k < c.ref.size(); k++) c.ref[k] = toupper(c.ref[k]);
+			continue;
+		}
+		c.len += chrm_pad;
+		mt19937_64 rng(seed ^ string_hash(c.name));
+		c.ref.resize(c.len);
+		for(int k = 0; k < c.len; k++) c.ref[k] = "ACGT"[rng() & 3];
+	}
+	if(fx != NULL) fai_destroy(fx);
+	return 0;
+}
+
+// SNPs with a diploid GT; the first allele of GT goes to haplotype 1, the second to haplotype 2
+static int load_variants(vector<sim_chrm> &chrms)
+{
+	ifstream fin(vcf_in.c_str());
+	if(fin.fail())
+	{
+		fprintf(stderr, "cannot open variants %s\n", vcf_in.c_str());
+		return -1;
+	}
+
+	map<string, int> m;
+	for(int i = 0; i < chrms.size(); i++) m.insert(pair<string, int>(chrms[i].name, i));
+
+	int n = 0;
+	string line;
+	while(getline(fin, line))
+	{
+		if(line.size() == 0 || line[0] == '#') continue;
+		vector<string> lf = split(line, "\t");
+		if(lf.size() < 10) continue;
+		if(m.find(lf[0]) == m.end()) continue;
+
+		sim_chrm &c = chrms[m[lf[0]]];
+		int32_t p = atoi(lf[1].c_str()) - 1;
+		if(p < 0 || p >= c.len) continue;
+
+		vector<string> alleles = split(lf[4], ",");
+		alleles.insert(alleles.begin(), lf[3]);
+		bool snv = true;
+		for(int k = 0; k < alleles.size(); k++) if(alleles[k].size() != 1) snv = false;
+		if(snv == false) continue;
+
+		const string &gt = lf[9];
+		if(gt.size() < 3 || gt[0] < '0' || gt[0] > '9' || gt[2] < '0' || gt[2] > '9') continue;
+		int i1 = gt[0] - '0';
+		int i2 = gt[2] - '0';
+		if(i1 >= alleles.size() || i2 >= alleles.size()) continue;
+
+		c.ref[p] = toupper(alleles[0][0]);
+		c.alleles[0][p] = toupper(alleles[i1][0]);
+		c.alleles[1][p] = toupper(alleles[i2][0]);
+		n++;
+	}
+	printf("loaded %d single-base variants from %s\n", n, vcf_in.c_str());
+	return 0;
+}
+
+// genomic blocks of [s, e) on the spliced transcript t
+static int project(const transcript &t, int32_t s, int32_t e, vector<PI> &blocks)
+{
+	blocks.clear();
+	int32_t k = 0;
+	for(int i = 0; i < t.exons.size(); i++)
+	{
+		int32_t a = t.exons[i].first.p32;
+		int32_t b = t.exons[i].second.p32;
+		int32_t x = max(s, k);
+		int32_t y = min(e, k + b - a);
+		if(x < y) blocks.push_back(PI(a + x - k, a + y - k));
+		k += b - a;
+	}
+	return 0;
+}
+
+static int32_t transcript_length(const transcript &t)
+{
+	int32_t n = 0;
+	for(int i = 0; i < t.exons.size(); i++) n += t.exons[i].second.p32 - t.exons[i].first.p32;
+	return n;
+}
+
+static int simulate_fragments(const sim_chrm &c, mt19937_64 &rng, vector<sim_frag> &frags, vector<sim_read> &reads)
+{
+	uniform_real_distribution<double> unif(0, 1);
+	normal_distribution<double> norm(insert_mean, insert_sd);
+
+	for(int t = 0; t < c.trsts.size(); t++)
+	{
+		int32_t len = transcript_length(c.trsts[t]);
+		if(len < read_length) continue;
+
+		long n = lround(depth * len / (2.0 * read_length));
+		for(long i = 0; i < n; i++)
+		{
+			sim_frag fr;
+			fr.t = t;
+			fr.f = lround(norm(rng));
+			if(fr.f < read_length) fr.f = read_length;
+			if(fr.f > len) fr.f = len;
+			fr.s = (int32_t)(unif(rng) * (len - fr.f + 1));
+			if(fr.s > len - fr.f) fr.s = len - fr.f;
+			fr.hap = unif(rng) < allele_ratio ? 0 : 1;
+			fr.first = unif(rng) < 0.5 ? 0 : 1;
+			fr.vw = 0;
+			if(wasp_tags) fr.vw = unif(rng) < wasp_fail ? 2 + (int8_t)(unif(rng) * 6) : 1;
+
+			vector<PI> b1, b2;
+			project(c.trsts[t], fr.s, fr.s + read_length, b1);
+			project(c.trsts[t], fr.s + fr.f - read_length, fr.s + fr.f, b2);
+
+			sim_read r;
+			r.frag = frags.size();
+			r.pos = b1.front().first;
+			r.mate = 0;
+			reads.push_back(r);
+			r.pos = b2.front().first;
+			r.mate = 1;
+			reads.push_back(r);
+			frags.push_back(fr);
+		}
+	}
+	sort(reads.begin(), reads.end());
+	return 0;
+}
+
+static uint8_t nt16(char c)
+{
+	if(c == 'A') return 1;
+	if(c == 'C') return 2;
+	if(c == 'G') return 4;
+	if(c == 'T') return 8;
+	return 15;
+}
+
+static int append_aux(vector<uint8_t> &aux, const char *tag, char type, const void *v, int n)
+{
+	aux.push_back(tag[0]);
+	aux.push_back(tag[1]);
+	aux.push_back(type);
+	const uint8_t *p = (const uint8_t*)v;
+	aux.insert(aux.end(), p, p + n);
+	return 0;
+}
+
+static int build_record(const sim_chrm &c, int tid, const vector<sim_frag> &frags, const sim_read &r, bam1_t *b)
+{
+	const sim_frag &fr = frags[r.frag];
+	const transcript &t = c.trsts[fr.t];
+
+	vector<PI> b1, b2;
+	project(t, fr.s, fr.s + read_length, b1);
+	project(t, fr.s + fr.f - read_length, fr.s + fr.f, b2);
+	const vector<PI> &bs = (r.mate == 0) ? b1 : b2;
+	const vector<PI> &bm = (r.mate == 0) ? b2 : b1;
+
+	// cigar and sequence from the haplotype
+	vector<uint32_t> cigar;
+	string seq;
+	bool has_snp = false;
+	for(int k = 0; k < bs.size(); k++)
+	{
+		if(k >= 1) cigar.push_back((bs[k].first - bs[k - 1].second) << BAM_CIGAR_SHIFT | BAM_CREF_SKIP);
+		cigar.push_back((bs[k].second - bs[k].first) << BAM_CIGAR_SHIFT | BAM_CMATCH);
+		seq += c.ref.substr(bs[k].first, bs[k].second - bs[k].first);
+
+		const map<int32_t, char> &m = c.alleles[fr.hap];
+		map<int32_t, char>::const_iterator it = m.lower_bound(bs[k].first);
+		for(; it != m.end() && it->first < bs[k].second; it++)
+		{
+			seq[seq.size() - (bs[k].second - it->first)] = it->second;
+			has_snp = true;
+		}
+	}
+
+	// aux: NH, XS for spliced reads, vW for reads over SNPs
+	vector<uint8_t> aux;
+	uint8_t nh = 1;
+	append_aux(aux, "NH", 'C', &nh, 1);
+	if(bs.size() >= 2 && (t.strand == '+' || t.strand == '-')) append_aux(aux, "XS", 'A', &t.strand, 1);
+	if(has_snp && fr.vw > 0)
+	{
+		uint8_t vw = fr.vw;
+		append_aux(aux, "vW", 'C', &vw, 1);
+	}
+
+	// fragments are numbered per chromosome
+	string qname = "sim." + c.name + "." + tostring(r.frag);
+	int nul = 4 - qname.size() % 4;
+	int l_qname = qname.size() + nul;
+	int l_seq = seq.size();
+	int l_data = l_qname + 4 * cigar.size() + (l_seq + 1) / 2 + l_seq + aux.size();
+	if(b->m_data < l_data)
+	{
+		b->m_data = l_data;
+		b->data = (uint8_t*)realloc(b->data, l_data);
+	}
+	b->l_data = l_data;
+
+	uint8_t *p = b->data;
+	memcpy(p, qname.c_str(), qname.size());
+	memset(p + qname.size(), 0, nul);
+	p += l_qname;
+	memcpy(p, cigar.data(), 4 * cigar.size());
+	p += 4 * cigar.size();
+	memset(p, 0, (l_seq + 1) / 2);
+	for(int k = 0; k < l_seq; k++) p[k / 2] |= nt16(seq[k]) << ((k % 2 == 0) ? 4 : 0);
+	p += (l_seq + 1) / 2;
+	memset(p, 30, l_seq);
+	p += l_seq;
+	memcpy(p, aux.data(), aux.size());
+
+	// the left mate is forward, the right mate is reverse
+	int32_t fl = b1.front().first;
+	int32_t fr2 = b2.back().second;
+	bool read1 = (r.mate == fr.first);
+	b->core.tid = tid;
+	b->core.pos = bs.front().first;
+	b->core.qual = 60;
+	b->core.l_qname = l_qname;
+	b->core.l_extranul = nul - 1;
+	b->core.flag = BAM_FPAIRED | BAM_FPROPER_PAIR | (read1 ? BAM_FREAD1 : BAM_FREAD2) | (r.mate == 0 ? BAM_FMREVERSE : BAM_FREVERSE);
+	b->core.n_cigar = cigar.size();
+	b->core.l_qseq = l_seq;
+	b->core.mtid = tid;
+	b->core.mpos = bm.front().first;
+	b->core.isize = (r.mate == 0) ? fr2 - fl : fl - fr2;
+	b->core.bin = bam_reg2bin(bs.front().first, bs.back().second);
+	return 0;
+}
+
+static bam_hdr_t* build_header(const vector<sim_chrm> &chrms, int argc, const char **argv)
+{
+	string text = "@HD\tVN:1.6\tSO:coordinate\n";
+	for(int i = 0; i < chrms.size(); i++) text += "@SQ\tSN:" + chrms[i].name + "\tLN:" + tostring(chrms[i].len) + "\n";
+	text += "@PG\tID:altai_simreads\tPN:altai_simreads\tCL:";
+	for(int i = 0; i < argc; i++) text += string(i == 0 ? "" : " ") + argv[i];
+	text += "\n";
+
+	bam_hdr_t *h = bam_hdr_init();
+	h->n_targets = chrms.size();
+	h->target_name = (char**)calloc(chrms.size(), sizeof(char*));
+	h->target_len = (uint32_t*)calloc(chrms.size(), sizeof(uint32_t));
+	for(int i = 0; i < chrms.size(); i++)
+	{
+		h->target_name[i] = strdup(chrms[i].name.c_str());
+		h->target_len[i] = chrms[i].len;
+	}
+	h->l_text = text.size();
+	h->text = strdup(text.c_str());
+	return h;
+}
+
+int main(int argc, const char **argv)
+{
+	if(parse_simreads_arguments(argc, argv) != 0)
+	{
+		print_simreads_help();
+		return 1;
+	}
+
+	vector<sim_chrm> chrms;
+	if(load_transcripts(chrms) != 0) return 1;
+	if(load_reference(chrms) != 0) return 1;
+	if(load_variants(chrms) != 0) return 1;
+
+	samFile *fo = sam_open(bam_file.c_str(), "wb");
+	if(fo == NULL)
+	{
+		fprintf(stderr, "cannot open %s to write alignments\n", bam_file.c_str());
+		return 1;
+	}
+	bam_hdr_t *hdr = build_header(chrms, argc, argv);
+	sam_hdr_write(fo, hdr);
+
+	// one stream per chromosome, so adding a chromosome does not change the others
+	long total = 0;
+	bam1_t *b = bam_init1();
+	for(int i = 0; i < chrms.size(); i++)
+	{
+		mt19937_64 rng(seed ^ (string_hash(chrms[i].name) << 1));
+		vector<sim_frag> frags;
+		vector<sim_read> reads;
+		simulate_fragments(chrms[i], rng, frags, reads);
+		for(int k = 0; k < reads.size(); k++)
+		{
+			build_record(chrms[i], i, frags, reads[k], b);
+			sam_write1(fo, hdr, b);
+		}
+		printf("chromosome %s: %lu transcripts, %lu fragments, %lu reads\n", chrms[i].name.c_str(), chrms[i].trsts.size(), frags.size(), reads.size());
+		total += reads.size();
+	}
+	bam_destroy1(b);
+	bam_hdr_destroy(hdr);
+	sam_close(fo);
+
+	if(sam_index_build(bam_file.c_str(), 0) != 0) fprintf(stderr, "cannot index %s\n", bam_file.c_str());
+	printf("wrote %ld reads to %s\n", total, bam_file.c_str());
+	return 0;
+}
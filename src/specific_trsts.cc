@@ -203,7 +203,7 @@ vector<transcript> specific_trsts::union_of(const vector<transcript>& v1, const
 
 /*
 vector<transcript> specific_trsts::recover_full_from_partial_transcripts
-	(const vector<transcript>& full_txs, const vector<transcript>& part_txs, double min_chain_overlap_ratio, bool will_change_gt)
+	(const vector<transcript>& full_txs, const vector<transcript>& part_txs, double min_chain_overlap_ratio, bool will_change_gt, const vcf_data *vcf)
 {
 	vector<transcript> recovered;
 	set<int> recovered_hasing;
@@ -231,7 +231,7 @@ vector<transcript> specific_trsts::recover_full_from_partial_transcripts
 				transcript t(fullt);
 				t.coverage = partt.coverage;
 
-				if (will_change_gt) t.transform_gt(partt.gt);
+				if (will_change_gt) t.transform_gt(partt.gt, vcf);
 				else assert(!gt_conflict(fullt.gt, partt.gt));
 				
 				recovered.push_back(t);
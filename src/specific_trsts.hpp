@@ -21,7 +21,7 @@ namespace specific_trsts {
     vector<transcript> exclusive_of_1 (const vector<transcript>& v1, const vector<transcript>& v2);
 	vector<transcript> union_of		  (const vector<transcript>& v1, const vector<transcript>& v2);
 	vector<transcript> recover_full_from_partial_transcripts
-		(const vector<transcript>& full_txs, const vector<transcript>& part_txs, double min_chain_overlap_ratio, bool will_change_gt);
+		(const vector<transcript>& full_txs, const vector<transcript>& part_txs, double min_chain_overlap_ratio, bool will_change_gt, const vcf_data *vcf);
 }
 
 #endif
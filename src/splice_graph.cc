@@ -124,6 +124,42 @@ int splice_graph::copy(const splice_graph &gr, MEE &x2y, MEE &y2x)
 	return 0;
 }
 
+/*
+*	ve: edges of gr to be copied, in this order
+*	ew: ew[k] is the weight of the copy of ve[k]
+*	ye: ye[k] is the new edge copied from ve[k]
+*	vertices are copied as in copy(gr, x2y, y2x); edges keep the order of ve, not their addresses
+*/
+int splice_graph::copy(const splice_graph &gr, const VE &ve, const vector<double> &ew, VE &ye)
+{
+	assert(ve.size() == ew.size());
+	clear();
+	chrm = gr.chrm;
+	gid = gr.gid;
+	strand = gr.strand;
+
+	for(int i = 0; i < gr.num_vertices(); i++)
+	{
+		add_vertex();
+		set_vertex_weight(i, gr.get_vertex_weight(i));
+		set_vertex_info(i, gr.get_vertex_info(i));
+	}
+
+	ye.assign(ve.size(), null_edge);
+	for(int k = 0; k < ve.size(); k++)
+	{
+		assert(ve[k] != null_edge);
+		edge_descriptor e = add_edge(ve[k]->source(), ve[k]->target());
+		set_edge_weight(e, ew[k]);
+		set_edge_info(e, gr.get_edge_info(ve[k]));
+
+		assert(e != NULL);
+		ye[k] = e;
+	}
+
+	return 0;
+}
+
 /*
 *	x2y: original to new
 *	y2x: new to original
@@ -170,8 +206,8 @@ int splice_graph::remove_edge(edge_descriptor e)
 	if(se.find(e) == se.end()) return -1;
 	vv[e->source()]->remove_out_edge(e);
 	vv[e->target()]->remove_in_edge(e);
-	delete e;
 	se.erase(e);
+	retired.push_back(e);
 	ewrt.erase(e);
 	einf.erase(e); 
 	
@@ -216,6 +252,7 @@ int splice_graph::clear()
 	vinf.clear();
 	ewrt.clear();
 	einf.clear();
+	rlog.clear();
 	return 0;
 }
 
@@ -228,7 +265,7 @@ double splice_graph::get_vertex_weight(int v) const
 	return vwrt[v];
 }
 
-vertex_info splice_graph::get_vertex_info(int v) const
+const vertex_info& splice_graph::get_vertex_info(int v) const
 {
 	assert(v >= 0 && v < vinf.size());
 	return vinf[v];
@@ -243,7 +280,7 @@ double splice_graph::get_edge_weight(edge_base *e) const
 	return -1;
 }
 
-edge_info splice_graph::get_edge_info(edge_base *e) const
+const edge_info& splice_graph::get_edge_info(edge_base *e) const
 {
 	MEIF::const_iterator it = einf.find(e);
 	assert(it != einf.end());
@@ -426,8 +463,17 @@ edge_descriptor splice_graph::compute_maximum_edge_w()
 	return max_edge;
 }
 
+/*
+**	apply the revision rules until none of them changes the graph
+**	rules are examined in the same order as before, but each of them only visits vertices 
+**	logged in rlog since its last examination, i.e., neighborhoods modified by any rule
+*/
 int splice_graph::revise_splice_graph()
 {
+	rlog.clear();
+	for(int i = 1; i < num_vertices() - 1; i++) rlog.push_back(i);
+
+	vector<int> k(8, 0);		// position in rlog up to which each rule has examined
 	bool b = false;
 	while(true)
 	{
@@ -437,30 +483,36 @@ int splice_graph::revise_splice_graph()
 		// b = remove_false_boundaries();
 		// if(b == true) continue;
 
-		b = remove_inner_boundaries();
+		b = remove_inner_boundaries(touched_vertices(k[0]));
 		if(b == true) continue;
 
-		b = remove_small_exons();
+		b = remove_small_exons(touched_vertices(k[1]));
 		if(b == true) continue;
 
-		b = remove_intron_contamination();
+		b = remove_intron_contamination(touched_vertices(k[2]));
 		if(b == true) continue;
 
-		b = remove_small_junctions();
+		b = remove_small_junctions(touched_vertices(k[3]));
 		if(b == true) refine_splice_graph();
 		if(b == true) continue;
 
-		b = extend_start_boundaries();
+		b = extend_start_boundaries(touched_vertices(k[4]));
 		if(b == true) continue;
 
-		b = extend_end_boundaries();
+		b = extend_end_boundaries(touched_vertices(k[5]));
 		if(b == true) continue;
 
-		b = extend_boundaries();
+		b = extend_boundaries(touched_vertices(k[6]));
 		if(b == true) refine_splice_graph();
 		if(b == true) continue;
 
-		b = keep_surviving_edges();
+		// keep_surviving_edges is not local; rerun it only if the graph is changed since
+		b = false;
+		if(k[7] < rlog.size())
+		{
+			k[7] = rlog.size();
+			b = keep_surviving_edges();
+		}
 		if(b == true) refine_splice_graph();
 		if(b == true) continue;
 
@@ -474,21 +526,69 @@ int splice_graph::revise_splice_graph()
 	return 0;
 }
 
+/*
+**	log v and its neighbors to rlog after v or its edges are modified;
+**	source and sink are never logged as no rule examines them or depends on their degrees
+*/
+int splice_graph::touch_vertex(int v)
+{
+	int n = num_vertices() - 1;
+	if(v <= 0 || v >= n) return 0;
+
+	rlog.push_back(v);
+	edge_iterator it1, it2;
+	PEEI pei;
+	for(pei = in_edges(v), it1 = pei.first, it2 = pei.second; it1 != it2; it1++)
+	{
+		int s = (*it1)->source();
+		if(s != 0) rlog.push_back(s);
+	}
+	for(pei = out_edges(v), it1 = pei.first, it2 = pei.second; it1 != it2; it1++)
+	{
+		int t = (*it1)->target();
+		if(t != n) rlog.push_back(t);
+	}
+	return 0;
+}
+
+// vertices logged in rlog since position k; k is moved to the end of rlog
+set<int> splice_graph::touched_vertices(int &k)
+{
+	assert(k >= 0 && k <= rlog.size());
+	set<int> vs(rlog.begin() + k, rlog.end());
+	k = rlog.size();
+	return vs;
+}
+
+// remove edges of vertices lacking in- or out-edges, until no more; only neighbors of a cleared vertex are revisited
 bool splice_graph::refine_splice_graph()
 {
 	bool flag = false;
-	while(true)
+	vector<int> q;
+	for(int i = num_vertices() - 2; i >= 1; i--) q.push_back(i);
+
+	while(q.size() >= 1)
 	{
-		bool b = false;
-		for(int i = 1; i < num_vertices() - 1; i++)
+		int i = q.back();
+		q.pop_back();
+
+		if(degree(i) == 0) continue;
+		if(in_degree(i) >= 1 && out_degree(i) >= 1) continue;
+
+		vector<int> nb;
+		edge_iterator it1, it2;
+		PEEI pei;
+		for(pei = in_edges(i), it1 = pei.first, it2 = pei.second; it1 != it2; it1++) nb.push_back((*it1)->source());
+		for(pei = out_edges(i), it1 = pei.first, it2 = pei.second; it1 != it2; it1++) nb.push_back((*it1)->target());
+
+		clear_vertex(i);
+		rlog.push_back(i);
+		for(int j : nb)
 		{
-			if(degree(i) == 0) continue;
-			if(in_degree(i) >= 1 && out_degree(i) >= 1) continue;
-			clear_vertex(i);
-			b = true;
-			flag = true;
+			touch_vertex(j);
+			if(j != 0 && j != num_vertices() - 1) q.push_back(j);
 		}
-		if(b == false) break;
+		flag = true;
 	}
 	return flag;
 }
@@ -761,7 +861,11 @@ bool splice_graph::keep_surviving_edges()
 	for(int i = 0; i < ve.size(); i++)
 	{
 		if(verbose >= 2) printf("remove edge (%d, %d), weight = %.2lf\n", ve[i]->source(), ve[i]->target(), get_edge_weight(ve[i]));
+		int s = ve[i]->source();
+		int t = ve[i]->target();
 		remove_edge(ve[i]);
+		touch_vertex(s);
+		touch_vertex(t);
 	}
 
 	if(ve.size() >= 1) return true;
@@ -769,13 +873,21 @@ bool splice_graph::keep_surviving_edges()
 
 }
 
-bool splice_graph::extend_boundaries()
+bool splice_graph::extend_boundaries(const set<int> &vs)
 {
+	// edges incident to vs, in the same (address) order as edges()
+	SE se;
 	edge_iterator it1, it2;
 	PEEI pei;
-	for(pei = edges(), it1 = pei.first, it2 = pei.second; it1 != it2; it1++)
+	for(int v : vs)
 	{
-		edge_descriptor e = (*it1);
+		for(pei = in_edges(v), it1 = pei.first, it2 = pei.second; it1 != it2; it1++) se.insert(*it1);
+		for(pei = out_edges(v), it1 = pei.first, it2 = pei.second; it1 != it2; it1++) se.insert(*it1);
+	}
+
+	for(SE::iterator it = se.begin(); it != se.end(); it++)
+	{
+		edge_descriptor e = (*it);
 		int s = e->source();
 		int t = e->target();
 		int32_t p = get_vertex_info(t).lpos - get_vertex_info(s).rpos;
@@ -807,6 +919,15 @@ bool splice_graph::extend_boundaries()
 		}
 
 		remove_edge(e);
+		touch_vertex(s);
+		touch_vertex(t);
+
+		// edges not examined yet are left for the next round
+		for(SE::iterator jt = std::next(it); jt != se.end(); jt++)
+		{
+			rlog.push_back((*jt)->source());
+			rlog.push_back((*jt)->target());
+		}
 
 		return true;
 	}
@@ -814,10 +935,10 @@ bool splice_graph::extend_boundaries()
 	return false;
 }
 
-bool splice_graph::extend_start_boundaries()
+bool splice_graph::extend_start_boundaries(const set<int> &vs)
 {
 	bool flag = false;
-	for(int i = 1; i < num_vertices() - 1; i++)
+	for(int i : vs)
 	{
 		PEB p = edge(0, i);
 		if(p.second == true) continue;
@@ -837,8 +958,9 @@ bool splice_graph::extend_start_boundaries()
 		edge_descriptor ee = add_edge(0, i);
 		set_edge_weight(ee, wv - we);
 		set_edge_info(ee, edge_info());
+		touch_vertex(i);
 
-		vertex_info vi = get_vertex_info(i);
+		const vertex_info &vi = get_vertex_info(i);
 		if(verbose >= 2) printf("extend start boundary: vertex = %d, wv = %.2lf, we = %.2lf, pos = %d%s\n", i, wv, we, vi.lpos.p32, vi.lpos.ale.c_str());
 
 		flag = true;
@@ -847,10 +969,10 @@ bool splice_graph::extend_start_boundaries()
 
 }
 
-bool splice_graph::extend_end_boundaries()
+bool splice_graph::extend_end_boundaries(const set<int> &vs)
 {
 	bool flag = false;
-	for(int i = 1; i < num_vertices() - 1; i++)
+	for(int i : vs)
 	{
 		PEB p = edge(i, num_vertices() - 1);
 		if(p.second == true) continue;
@@ -870,8 +992,9 @@ bool splice_graph::extend_end_boundaries()
 		edge_descriptor ee = add_edge(i, num_vertices() - 1);
 		set_edge_weight(ee, wv - we);
 		set_edge_info(ee, edge_info());
+		touch_vertex(i);
 
-		vertex_info vi = get_vertex_info(i);
+		const vertex_info &vi = get_vertex_info(i);
 		if(verbose >= 2) printf("extend end boundary: vertex = %d, wv = %.2lf, we = %.2lf, pos = %d%s\n", i, wv, we, vi.rpos.p32, vi.rpos.ale.c_str());
 
 		flag = true;
@@ -879,10 +1002,10 @@ bool splice_graph::extend_end_boundaries()
 	return flag;
 }
 
-bool splice_graph::remove_small_junctions()
+bool splice_graph::remove_small_junctions(const set<int> &vs)
 {
 	SE se0;
-	for(int i = 1; i < num_vertices() - 1; i++)
+	for(int i : vs)
 	{
 		if(degree(i) <= 0) continue;
 
@@ -963,24 +1086,27 @@ bool splice_graph::remove_small_junctions()
 		edge_descriptor e = (*it);
 		if(verbose >= 2) 
 		{
-			vertex_info v1 = get_vertex_info(e->source());
-			vertex_info v2 = get_vertex_info(e->target());
+			const vertex_info &v1 = get_vertex_info(e->source());
+			const vertex_info &v2 = get_vertex_info(e->target());
 			printf("remove small junction: length = %d, pos = %d%s-%d%s\n", v2.lpos - v1.rpos, v2.lpos.p32, v2.lpos.ale.c_str(), v1.rpos.p32, v1.rpos.ale.c_str());
 		}
+		int s = e->source();
+		int t = e->target();
 		remove_edge(e);
+		touch_vertex(s);
+		touch_vertex(t);
 	}
 
 	return true;
 }
 
 // TODO: not able to remove small single exon w. variants inside
-bool splice_graph::remove_small_exons()
+bool splice_graph::remove_small_exons(const set<int> &vs)
 {
 	bool flag = false;
-	for(int i = 1; i < num_vertices() - 1; i++)
+	for(int i : vs)
 	{
-		vertex_info vi = get_vertex_info(i);
-		if(vi.type == EMPTY_VERTEX) continue;
+		if(get_vertex_info(i).type == EMPTY_VERTEX) continue;
 
 		bool b = true;
 		edge_iterator it1, it2;
@@ -1016,21 +1142,21 @@ bool splice_graph::remove_small_exons()
 
 		//clear_vertex(i);
 		if(verbose >= 2) printf("remove small exon: length = %d, pos = %d-%d\n", p2 - p1, p1, p2);
-		vi.type = EMPTY_VERTEX;
-		set_vertex_info(i, vi);
+		vinf[i].type = EMPTY_VERTEX;
+		touch_vertex(i);
 
 		flag = true;
 	}
 	return flag;
 }
 
-bool splice_graph::remove_inner_boundaries()
+bool splice_graph::remove_inner_boundaries(const set<int> &vs)
 {
 	bool flag = false;
 	int n = num_vertices() - 1;
-	for(int i = 1; i < num_vertices() - 1; i++)
+	for(int i : vs)
 	{
-		vertex_info vi = get_vertex_info(i);
+		const vertex_info &vi = get_vertex_info(i);
 		if(vi.type == EMPTY_VERTEX) continue;
 		if(vi.lpos.ale != "$" || vi.rpos.ale != "$" ) continue;
 
@@ -1059,20 +1185,20 @@ bool splice_graph::remove_inner_boundaries()
 				i, get_vertex_weight(i), vi.length, vi.lpos.aspos32string().c_str(), vi.rpos.aspos32string().c_str());
 
 		// clear_vertex(i);
-		vi.type = EMPTY_VERTEX;
-		set_vertex_info(i, vi);
+		vinf[i].type = EMPTY_VERTEX;
+		touch_vertex(i);
 		flag = true;
 	}
 	return flag;
 }
 
 // FIXME: won't be removed if retained intron has variants
-bool splice_graph::remove_intron_contamination()
+bool splice_graph::remove_intron_contamination(const set<int> &vs)
 {
 	bool flag = false;
-	for(int i = 1; i < num_vertices(); i++)
+	for(int i : vs)
 	{
-		vertex_info vi = get_vertex_info(i);
+		const vertex_info &vi = get_vertex_info(i);
 		if(vi.type == EMPTY_VERTEX) continue;
 		
 		if(in_degree(i) != 1) continue;
@@ -1106,8 +1232,8 @@ bool splice_graph::remove_intron_contamination()
 		if(verbose >= 2) printf("clear intron contamination %d, weight = %.2lf, length = %d, edge weight = %.2lf\n", i, wv, vi.length, we);
 
 		// clear_vertex(i);
-		vi.type = EMPTY_VERTEX;
-		set_vertex_info(i, vi);
+		vinf[i].type = EMPTY_VERTEX;
+		touch_vertex(i);
 
 		flag = true;
 	}
@@ -1244,10 +1370,13 @@ int splice_graph::simulate(int nv, int ne, int mw)
 		}
 	}
 
+	// remove_edge also erases from ewrt, so collect the edges first
+	VE ve;
 	for(MED::iterator it = ewrt.begin(); it != ewrt.end(); it++)
 	{
-		if(med.find(it->first) == med.end()) remove_edge(it->first);
+		if(med.find(it->first) == med.end()) ve.push_back(it->first);
 	}
+	for(int i = 0; i < ve.size(); i++) remove_edge(ve[i]);
 
 	ewrt = med;
 	einf.clear();
@@ -1287,7 +1416,7 @@ int splice_graph::simulate(int nv, int ne, int mw)
 		if(degree(i) >= 1) vv++;
 	}
 	int delta = num_edges() - vv + 2;
-	printf("simulate %d vertices, %lu edges, %.0lf max-flow, delta = %d\n", vv, num_edges(), vwrt[0], delta);
+	if(verbose >= 1) printf("simulate %d vertices, %lu edges, %.0lf max-flow, delta = %d\n", vv, num_edges(), vwrt[0], delta);
 
 	return 0;
 }
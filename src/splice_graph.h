@@ -23,7 +23,7 @@ See LICENSE for licensing.
 using namespace std;
 
 typedef map<int, genotype> MII;
-typedef map<edge_descriptor, edge_info> MEIF;
+typedef map<edge_descriptor, edge_info, edge_less> MEIF;
 typedef pair<edge_descriptor, edge_info> PEIF;
 
 class splice_graph : public directed_graph
@@ -43,6 +43,7 @@ public:
 	vector<vertex_info> vinf;
 	MED ewrt;
 	MEIF einf;
+	vector<int> rlog;		// vertices (and neighbors) modified during revision, in order; see touch_vertex
 
 public:
 	int edge_integrity_examine() const;
@@ -51,8 +52,8 @@ public:
 	// get and set properties
 	double get_vertex_weight(int v) const;
 	double get_edge_weight(edge_base *e) const;
-	vertex_info get_vertex_info(int v) const;
-	edge_info get_edge_info(edge_base *e) const;
+	const vertex_info& get_vertex_info(int v) const;
+	const edge_info& get_edge_info(edge_base *e) const;
 
 	int set_vertex_weight(int v, double w);
 	int set_vertex_info(int v, const vertex_info &vi);
@@ -76,23 +77,27 @@ public:
 	// modify the splice_graph
 	int clear();
 	int copy(const splice_graph &gr, MEE &x2y, MEE &y2x);
+	int copy(const splice_graph &gr, const VE &ve, const vector<double> &ew, VE &ye);
 	int allelic_copy(const splice_graph &gr, MEE &x2y, MEE &y2x, genotype gt);
 	int remove_edge(edge_descriptor e);
 	int remove_edge(int s, int t);
 
 	// revise splice graph
+	// each rule only examines vertices in vs, i.e., those touched since the rule was last examined
+	int touch_vertex(int v);
+	set<int> touched_vertices(int &k);
 	VE compute_maximal_edges();
 	int survivived_edges_for_allele(genotype gt, SE& se0, set<int>& sv1, set<int>& sv2);
 	int revise_splice_graph();
 	bool refine_splice_graph();
 	bool keep_surviving_edges();
-	bool extend_boundaries();
-	bool extend_start_boundaries();
-	bool extend_end_boundaries();
-	bool remove_small_junctions();
-	bool remove_small_exons();
-	bool remove_inner_boundaries();
-	bool remove_intron_contamination();
+	bool extend_boundaries(const set<int> &vs);
+	bool extend_start_boundaries(const set<int> &vs);
+	bool extend_end_boundaries(const set<int> &vs);
+	bool remove_small_junctions(const set<int> &vs);
+	bool remove_small_exons(const set<int> &vs);
+	bool remove_inner_boundaries(const set<int> &vs);
+	bool remove_intron_contamination(const set<int> &vs);
 
 	// read, write, and simulate splice graph
 	int build(const string &file);
@@ -6,6 +6,7 @@ See LICENSE for licensing.
 
 #include "super_graph.h"
 #include "config.h"
+#include "run_stats.h"
 #include <algorithm>
 #include <cfloat>
 
@@ -18,6 +19,7 @@ super_graph::~super_graph()
 
 int super_graph::build()
 {
+	stage_timer st(STAGE_SUPER_GRAPH);
 	subs.clear();
 	hss.clear();
 
@@ -0,0 +1,32 @@
+#!/bin/sh
+# reads simulated on the transcripts of the example are assembled with and without --max_num_bundle_hits;
+# the downsampled bundles must report about the same coverage, summed over the transcripts found by both runs
+
+srcdir=${srcdir:-.}
+ex=$srcdir/../ex
+out=test_bundle_cap.out
+insert="--insertsize_median 250 --insertsize_low 50 --insertsize_high 600"
+
+rm -rf $out
+mkdir -p $out
+
+./altai -i $ex/altai-eg.bam -j $ex/altai-eg.vcf -o $out/eg $insert > $out/eg.log 2>&1 || exit 1
+./altai_simreads -g $out/eg.merged.gtf -v $ex/altai-eg.vcf -o $out/sim.bam --depth 10 --seed 7 > $out/sim.log 2>&1 || exit 1
+
+# the two bundles have about 14000 and 18000 reads, a cap of 9000 keeps 64% and 49% of them
+./altai -i $out/sim.bam -j $ex/altai-eg.vcf -o $out/full $insert > $out/full.log 2>&1 || exit 1
+./altai -i $out/sim.bam -j $ex/altai-eg.vcf -o $out/cap $insert --max_num_bundle_hits 9000 > $out/cap.log 2>&1 || exit 1
+if ! grep -q "downsampled" $out/cap.log; then echo "no bundle was downsampled"; exit 1; fi
+
+# coverage summed per strand and exon chain
+for r in full cap; do
+	awk '$1 !~ /^#/ && $3 == "transcript" { match($0, /transcript_id "[^"]*"/); id = substr($0, RSTART, RLENGTH); match($0, /cov "[^"]*"/); cov[id] = substr($0, RSTART + 5, RLENGTH - 6); s[id] = $1 $7 }
+		$1 !~ /^#/ && $3 == "exon" { match($0, /transcript_id "[^"]*"/); id = substr($0, RSTART, RLENGTH); c[id] = c[id] "," $4 "-" $5 }
+		END { for(id in c) sum[s[id] c[id]] += cov[id]; for(k in sum) print k, sum[k] }' $out/$r.merged.gtf | sort > $out/$r.chains
+done
+
+ratio=`join $out/full.chains $out/cap.chains | awk '{x += $2; y += $3} END {if(x > 0) printf "%.3f", y / x}'`
+if [ "$ratio" = "" ]; then echo "no transcript is found by both runs"; exit 1; fi
+if awk -v r=$ratio 'BEGIN {exit !(r >= 0.8 && r <= 1.25)}'; then exit 0; fi
+echo "coverage with the cap is $ratio of that without"
+exit 1
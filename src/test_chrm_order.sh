@@ -0,0 +1,34 @@
+#!/bin/sh
+# reads simulated on three chromosomes are assembled with small batches of bundles;
+# every output file must list the transcripts of each chromosome in one block, in the order of the BAM header
+
+srcdir=${srcdir:-.}
+ex=$srcdir/../ex
+out=test_chrm_order.out
+insert="--insertsize_median 250 --insertsize_low 50 --insertsize_high 600"
+
+rm -rf $out
+mkdir -p $out
+
+# transcript models from the example, copied to chromosomes 1, 2 and 3, with the same variants on each
+./altai -i $ex/altai-eg.bam -j $ex/altai-eg.vcf -o $out/eg $insert > $out/eg.log 2>&1 || exit 1
+for c in 1 2 3; do awk -v c=$c '$1 == "1" {sub(/^1\t/, c "\t"); gsub(/_id "/, "&c" c "."); print}' $out/eg.merged.gtf; done > $out/models.gtf
+grep "^#" $ex/altai-eg.vcf > $out/variants.vcf
+for c in 1 2 3; do awk -v c=$c '$1 == "1" {sub(/^1\t/, c "\t"); print}' $ex/altai-eg.vcf; done >> $out/variants.vcf
+
+./altai_simreads -g $out/models.gtf -v $out/variants.vcf -o $out/sim.bam --depth 4 --seed 7 > $out/sim.log 2>&1 || exit 1
+./altai -i $out/sim.bam -j $out/variants.vcf -o $out/sim $insert --batch_bundle_size 1 > $out/sim.log 2>&1 || exit 1
+
+status=0
+for f in $out/sim.*.gtf $out/sim.*.gvf; do
+	order=`awk '$1 !~ /^#/ && $1 != p {printf "%s ", $1; p = $1}' $f`
+	case "$order" in
+		""|"1 "|"1 2 "|"1 2 3 "|"2 "|"2 3 "|"3 "|"1 3 ") ;;
+		*) echo "$f: chromosomes written in the order $order"; status=1 ;;
+	esac
+done
+
+chrms=`awk '$1 !~ /^#/ {print $1}' $out/sim.merged.gtf | sort -u | tr '\n' ' '`
+if [ "$chrms" != "1 2 3 " ]; then echo "sim.merged.gtf: transcripts on chromosomes $chrms, expected 1 2 3"; status=1; fi
+
+exit $status
@@ -5,6 +5,7 @@ See LICENSE for licensing.
 */
 
 #include <cassert>
+#include <algorithm>
 #include "transcript_set.h"
 #include "config.h"
 
@@ -19,6 +20,13 @@ trans_item::trans_item(const transcript &t, int c, int s)
 	else if(samples[s] < t.coverage) samples[s] = t.coverage;
 }
 
+trans_item::trans_item(transcript &&t, int c, int s)
+{
+	samples.insert(make_pair(s, t.coverage));
+	trst = std::move(t);
+	count = c;
+}
+
 int trans_item::merge(const trans_item &ti, int mode)
 {
 	if(mode == TRANSCRIPT_COUNT_ADD_COVERAGE_ADD) 
@@ -106,44 +114,6 @@ int trans_item::merge(const trans_item &ti, int mode)
 	return 0;
 }
 
-int merge_sorted_trans_items(vector<trans_item> &vx, const vector<trans_item> &vy, int mode1, int mode2, double single_exon_ratio)
-{
-	vector<trans_item> vz;
-	int kx = 0, ky = 0;
-	while(kx < vx.size() && ky < vy.size())
-	{
-		int b = vx[kx].trst.compare1(vy[ky].trst, single_exon_ratio);
-		if(b == 0)
-		{
-			if(vx[kx].trst.exons.size() <= 1) vx[kx].merge(vy[ky], mode1);
-			if(vx[kx].trst.exons.size() >= 2) vx[kx].merge(vy[ky], mode2);
-			vz.push_back(vx[kx]);
-			kx++;
-			ky++;
-		}
-		else if(b == 1)
-		{
-			vz.push_back(vx[kx]);
-			kx++;
-		}
-		else if(b == -1)
-		{
-			vz.push_back(vy[ky]);
-			ky++;
-		}
-		else assert(false);
-	}
-
-	assert(kx == vx.size() || ky == vy.size());
-
-	for(int i = kx; i < vx.size(); i++) vz.push_back(vx[i]);
-	for(int i = ky; i < vy.size(); i++) vz.push_back(vy[i]);
-
-	vx.clear();
-	vx = vz;
-	return 0;
-}
-
 transcript_set::transcript_set(const string &c, double s)
 {
 	chrm = c;
@@ -156,45 +126,89 @@ transcript_set::transcript_set(const transcript &t, int count, int sid, double o
 	single_exon_overlap = overlap;
 
 	size_t h = t.get_intron_chain_hashing();
-	trans_item ti(t, count, sid);
-	vector<trans_item> v;
-	v.push_back(std::move(ti));
-
-	mt.insert(make_pair(h, v));
+	mt[h].push_back(trans_item(t, count, sid));
 }
 
 int transcript_set::add(const transcript &t, int count, int sid, int mode1, int mode2)
 {
-	transcript_set ts(t, count, sid, this->single_exon_overlap);
-	add(ts, mode1, mode2);
-	return 0;
+	return add(transcript(t), count, sid, mode1, mode2);
+}
+
+int transcript_set::add(transcript &&t, int count, int sid, int mode1, int mode2)
+{
+	size_t h = t.get_intron_chain_hashing();
+	return insert(h, trans_item(std::move(t), count, sid), mode1, mode2);
 }
 
 int transcript_set::add(const transcript_set &ts, int mode1, int mode2)
 {
-	//boost::asio::thread_pool pool(threads);
 	for(auto &x : ts.mt)
 	{
-		map<size_t, vector<trans_item>>::iterator z = mt.find(x.first);
+		auto z = mt.find(x.first);
 		if(z == mt.end())
 		{
 			mt.insert(x);
+			continue;
 		}
-		else
+		for(const trans_item &ti : x.second) insert(x.first, trans_item(ti), mode1, mode2);
+	}
+	return 0;
+}
+
+int transcript_set::add(transcript_set &&ts, int mode1, int mode2)
+{
+	for(auto &x : ts.mt)
+	{
+		auto z = mt.find(x.first);
+		if(z == mt.end())
 		{
-			merge_sorted_trans_items(z->second, x.second, mode1, mode2, single_exon_overlap);
-			/*
-			vector<trans_item> &zz = z->second;
-			const vector<trans_item> &xx = x.second;
-			if(threads <= 0) merge_sorted_trans_items(zz, xx, mode);
-			else boost::asio::post(pool, [&zz, &xx, mode] { merge_sorted_trans_items(zz, xx, mode); });
-			*/
+			mt.insert(make_pair(x.first, std::move(x.second)));
+			continue;
 		}
+		for(trans_item &ti : x.second) insert(x.first, std::move(ti), mode1, mode2);
 	}
-	//pool.join();
+	ts.mt.clear();
 	return 0;
 }
 
+/*
+**	put ti into bucket h, which is sorted by transcript::compare1;
+**	ti is merged into the item equal to it (if any), otherwise inserted at its sorted position
+*/
+int transcript_set::insert(size_t h, trans_item &&ti, int mode1, int mode2)
+{
+	vector<trans_item> &v = mt[h];
+
+	// first item not preceding ti
+	int a = 0, b = v.size();
+	while(a < b)
+	{
+		int m = (a + b) / 2;
+		if(v[m].trst.compare1(ti.trst, single_exon_overlap) == 1) a = m + 1;
+		else b = m;
+	}
+
+	if(a < v.size() && v[a].trst.compare1(ti.trst, single_exon_overlap) == 0)
+	{
+		if(v[a].trst.exons.size() <= 1) v[a].merge(ti, mode1);
+		if(v[a].trst.exons.size() >= 2) v[a].merge(ti, mode2);
+	}
+	else
+	{
+		v.insert(v.begin() + a, std::move(ti));
+	}
+	return 0;
+}
+
+// keys of mt in ascending order, so that transcripts are retrieved in a fixed order
+vector<size_t> transcript_set::sorted_keys() const
+{
+	vector<size_t> v;
+	for(auto &x : mt) v.push_back(x.first);
+	sort(v.begin(), v.end());
+	return v;
+}
+
 int transcript_set::print() const
 {
 	printf("transcript-set: chrm = %s, mt.size() = %lu\n", chrm.c_str(), mt.size());
@@ -204,9 +218,9 @@ int transcript_set::print() const
 vector<transcript> transcript_set::get_transcripts(int min_count) const
 {
 	vector<transcript> v;
-	for(auto &x : mt)
+	for(size_t h : sorted_keys())
 	{
-		for(auto &z : x.second)
+		for(auto &z : mt.at(h))
 		{
 			if(z.count < min_count) continue;
 			v.push_back(z.trst);
@@ -218,9 +232,9 @@ vector<transcript> transcript_set::get_transcripts(int min_count) const
 vector<transcript> transcript_set::get_transcripts(int min_count_single, int min_count_multi) const
 {
 	vector<transcript> v;
-	for(auto &x : mt)
+	for(size_t h : sorted_keys())
 	{
-		for(auto &z : x.second)
+		for(auto &z : mt.at(h))
 		{
 			if(z.trst.exons.size() <= 1 && z.count < min_count_single) continue;
 			if(z.trst.exons.size() >= 2 && z.count < min_count_multi) continue;
@@ -9,6 +9,7 @@ See LICENSE for licensing.
 #define __TRANSCRIPT_SET_H__
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include "transcript.h"
@@ -20,6 +21,7 @@ class trans_item
 public:
 	trans_item();
 	trans_item(const transcript &t, int count, int sid);
+	trans_item(transcript &&t, int count, int sid);
 
 public:
 	transcript trst;
@@ -30,8 +32,6 @@ public:
 	int merge(const trans_item &ti, int mode);
 };
 
-int merge_sorted_trans_items(vector<trans_item> &vx, const vector<trans_item> &vy, int mode1, int mode2, double single_exon_overlap);
-
 class transcript_set
 {
 public:
@@ -40,18 +40,24 @@ public:
 
 public:
 	string chrm;
-	map<size_t, vector<trans_item>> mt;
+	unordered_map<size_t, vector<trans_item>> mt;		// intron-chain hashing -> items sorted by transcript::compare1
 	double single_exon_overlap;
 
 public:
 	int add(const transcript &t, int count, int sid, int mode1, int mode2);
+	int add(transcript &&t, int count, int sid, int mode1, int mode2);
 	int add(const transcript_set &ts, int mode1, int mode2);
+	int add(transcript_set &&ts, int mode1, int mode2);
 	// int increase_count(int count);
 	// int filter(int min_count);
 	int print() const;
 	// pair<bool, trans_item> query(const transcript &t) const;
 	vector<transcript> get_transcripts(int min_count) const;
 	vector<transcript> get_transcripts(int min1, int min2) const;
+
+private:
+	int insert(size_t h, trans_item &&ti, int mode1, int mode2);
+	vector<size_t> sorted_keys() const;
 };
 
 #endif
@@ -77,13 +77,44 @@ vcf_data::vcf_data(std::string file_name)
 	read_as_counts(file_name);
 }
 
+/*
+** in-memory counterpart of a vcf line: ale1 and ale2 are the alleles of GT (e.g., ref and alt for 0|1)
+*/
+int vcf_data::add(const string &chrm, int pos, const string &ref, const string &ale1, const string &ale2, bool phased)
+{
+	assert(ref.length() >= 1);
+	string r = toupperstring(ref);
+	string a1 = toupperstring(ale1);
+	string a2 = toupperstring(ale2);
+
+	map<string, genotype> ng;
+	if(a1 == a2)
+	{
+		ng.insert({a1, NONSPECIFIC});
+	}
+	else if(phased)
+	{
+		ng.insert({a1, ALLELE1});
+		ng.insert({a2, ALLELE2});
+	}
+	else
+	{
+		ng.insert({r, UNPHASED});
+		ng.insert({a1, UNPHASED});
+		ng.insert({a2, UNPHASED});
+	}
+	vcf_pos_map[chrm][pos] = ng;
+	vcf_ale_len[chrm][pos] = r.size();
+	return 0;
+}
+
 /*
 ** @return ALLELE1, ALLELE2, NONSPECIFIC, if not found, UNPHASED 
 */
-genotype vcf_data::get_genotype(string chrm, int pos, string ale)
+genotype vcf_data::get_genotype(const string &chrm, int pos, const string &ale) const
 {
-	auto vcf1 = vcf_map.find(chrm);
-	if(vcf1 == vcf_map.end()) return UNPHASED;
+	auto vcf1 = vcf_pos_map.find(chrm);
+	if(vcf1 == vcf_pos_map.end()) return UNPHASED;
 	
 	auto vcf2 = vcf1->second.find(pos);
 	if(vcf2 == vcf1->second.end()) return UNPHASED;
@@ -182,13 +213,51 @@ int vcf_data::read_as_counts(const string & name)
 }
 
 
-int vcf_data::increse_it(map <int, map <string, genotype> >::iterator &it1, map <int, int >::iterator &it2)
+const map<string, genotype>* vcf_data::get_alleles(const string &chrm, int pos) const
+{
+	auto vcf1 = vcf_pos_map.find(chrm);
+	if(vcf1 == vcf_pos_map.end()) return NULL;
+
+	auto vcf2 = vcf1->second.find(pos);
+	if(vcf2 == vcf1->second.end()) return NULL;
+	return &(vcf2->second);
+}
+
+int vcf_data::increse_it(map <int, map <string, genotype> >::const_iterator &it1, map <int, int >::const_iterator &it2)
 {
 	++it1;
 	++it2;
 	return 0;
 }
 
+// chromosomes without variants share these
+static const map <int, map <string, genotype> > no_variants;
+static const map <int, int > no_lengths;
+
+variant_cursor::variant_cursor()
+	: it(no_variants.end()), end(no_variants.end()), len_it(no_lengths.end()), len_end(no_lengths.end())
+{}
+
+int variant_cursor::seek(const vcf_data *vcf, const string &c)
+{
+	if(c == chrm) return 0;
+
+	chrm = c;
+	it = end = no_variants.end();
+	len_it = len_end = no_lengths.end();
+	if(vcf == NULL) return 0;
+
+	auto x = vcf->vcf_pos_map.find(c);
+	auto y = vcf->vcf_ale_len.find(c);
+	if(x == vcf->vcf_pos_map.end() || y == vcf->vcf_ale_len.end()) return 0;
+
+	it = x->second.begin();
+	end = x->second.end();
+	len_it = y->second.begin();
+	len_end = y->second.end();
+	return 0;
+}
+
 
 int vcf_data::print()
 {
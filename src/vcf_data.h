@@ -36,12 +36,31 @@ private:
 	int read_as_counts(const std::string &); // read .asf file, make vcf_map and vcf_pos_map
 
 public:
-	genotype get_genotype(string chrm, int pos, string ale); // return UNPHASED if not found
+	int add(const string &chrm, int pos, const string &ref, const string &ale1, const string &ale2, bool phased = true);	// 0-based pos, as a vcf line with GT ale1|ale2
+	genotype get_genotype(const string &chrm, int pos, const string &ale) const; // return UNPHASED if not found
+	const map<string, genotype>* get_alleles(const string &chrm, int pos) const;	// return NULL if not found
 	static string graphviz_gt_color_shape(genotype gt, int vertex_type);
-	static int increse_it(map <int, map <string, genotype> >::iterator &it1, map <int, int >::iterator &it2);
+	static int increse_it(map <int, map <string, genotype> >::const_iterator &it1, map <int, int >::const_iterator &it2);
 	int print();
 
 };
 
+// position in the variants of one chromosome; hits are read in sorted order and only move it forward
+class variant_cursor
+{
+public:
+	variant_cursor();
+
+public:
+	string chrm;
+	map <int, map <string, genotype> >::const_iterator it;
+	map <int, map <string, genotype> >::const_iterator end;
+	map <int, int >::const_iterator len_it;
+	map <int, int >::const_iterator len_end;
+
+public:
+	int seek(const vcf_data *vcf, const string &chrm);	// first variant of chrm, if not already on chrm; empty if vcf is NULL or has no chrm
+};
+
 
 #endif
\ No newline at end of file
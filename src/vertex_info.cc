@@ -56,27 +56,27 @@ bool vertex_info::is_allelic() const
 	else return false;
 }
 
-bool vertex_info::is_as_vertex() {return vertex_info::is_as_vertex(*this);}
+bool vertex_info::is_as_vertex() const {return vertex_info::is_as_vertex(*this);}
 
-bool vertex_info::is_adjacent_to_as_vertex() {return vertex_info::is_adjacent_to_as_vertex(*this);}
+bool vertex_info::is_adjacent_to_as_vertex() const {return vertex_info::is_adjacent_to_as_vertex(*this);}
 
-bool vertex_info::is_ordinary_vertex() {return vertex_info::is_ordinary_vertex(*this);}
+bool vertex_info::is_ordinary_vertex() const {return vertex_info::is_ordinary_vertex(*this);}
 
-bool vertex_info::is_as_vertex(vertex_info vi)
+bool vertex_info::is_as_vertex(const vertex_info &vi)
 {
 	if(DEBUG_MODE_ON) assert(vi.as_type>= 0 && vi.as_type <= 7);
 	if (vi.as_type == AS_DIPLOIDVAR || vi.as_type == AS_MONOPLOIDVAR) return true;
 	else return false;
 }
 
-bool vertex_info::is_adjacent_to_as_vertex(vertex_info vi)
+bool vertex_info::is_adjacent_to_as_vertex(const vertex_info &vi)
 {
 	if(DEBUG_MODE_ON) assert(vi.as_type>= 0 && vi.as_type <= 7);
 	if (vi.as_type == AJ_NSMONOVAR || vi.as_type == AJ_NONVAR) return true;
 	else return false;
 }
 
-bool vertex_info::is_ordinary_vertex(vertex_info vi)
+bool vertex_info::is_ordinary_vertex(const vertex_info &vi)
 {
 	if(DEBUG_MODE_ON) assert(vi.as_type>= 0 && vi.as_type <= 7);
 	if (vi.as_type == NS_NONVAR || vi.as_type == NS_MONOVAR) return true;
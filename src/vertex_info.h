@@ -58,13 +58,13 @@ public:
 
 public:
 	bool is_allelic() const;
-	bool is_as_vertex();
-	bool is_adjacent_to_as_vertex();
-	bool is_ordinary_vertex();
+	bool is_as_vertex() const;
+	bool is_adjacent_to_as_vertex() const;
+	bool is_ordinary_vertex() const;
 	
-	static bool is_as_vertex(vertex_info vi);
-	static bool is_adjacent_to_as_vertex(vertex_info vi);
-	static bool is_ordinary_vertex(vertex_info vi);
+	static bool is_as_vertex(const vertex_info &vi);
+	static bool is_adjacent_to_as_vertex(const vertex_info &vi);
+	static bool is_ordinary_vertex(const vertex_info &vi);
 };
 
 #endif